@@ -0,0 +1,284 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Offline replay benchmark for the detectors.
+Replays a directory of recorded frames, a recorder dump or a video through the detectors of
+GameAutomation and reports per-frame latency, frames/sec and accuracy against
+labeled health values, so optimizations can be compared against a baseline.
+
+Labels are an optional CSV with a header row: frame,health[,dead][,respawn]
+where `frame` is the file name (or frame index for videos), `health` is 0-1 or
+0-100, and `dead`/`respawn` are 0/1 (dead defaults to health == 0).
+
+With the native matcher built, the OpenCV and native kernels are also timed
+against each other on the health template search area of every frame.
+
+The change gates are reset before every frame so each call runs its detector;
+--gates keeps them live to measure the tick as it runs, cached results included.
+
+Usage: python benchmark.py recordings/ --labels recordings/labels.csv --output run.json
+"""
+
+import argparse
+import csv
+import json
+import os
+import time
+
+import cv2
+import numpy as np
+
+from capture import ReplayCapture
+from frame import Frame
+from main import GameAutomation
+from matching import GPU_BACKENDS, MATCHER_BACKENDS, NativeKernel, fastmatch
+from recorder import load_recording
+
+IMAGE_EXTENSIONS = (".png", ".jpg", ".jpeg", ".bmp")
+DETECTORS = ("match_health_template", "get_health_percentage", "is_health_empty", "detect_respawn_button")
+
+
+def load_frames(path):
+    """Yield (frame id, BGR image) from an image directory, a recorder dump or a video file"""
+    if os.path.isfile(os.path.join(path, "index.json")):
+        for index, crop, _ in load_recording(path):
+            yield str(index), np.ascontiguousarray(crop)
+        return
+
+    if os.path.isdir(path):
+        names = sorted(f for f in os.listdir(path) if f.lower().endswith(IMAGE_EXTENSIONS))
+        for name in names:
+            image = cv2.imread(os.path.join(path, name))
+            if image is None:
+                print(f"WARNING: Could not load {name}, skipping")
+                continue
+            yield name, image
+        return
+
+    video = cv2.VideoCapture(path)
+    if not video.isOpened():
+        raise RuntimeError(f"Cannot open {path} as an image directory or video")
+    index = 0
+    try:
+        while True:
+            ok, image = video.read()
+            if not ok:
+                break
+            yield str(index), image
+            index += 1
+    finally:
+        video.release()
+
+
+def load_labels(path):
+    """{frame id: {"health": ratio, "dead": bool, "respawn": bool or None}}"""
+    labels = {}
+    if not path:
+        return labels
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            health = float(row["health"])
+            if health > 1.0:
+                health /= 100.0
+            dead = row.get("dead")
+            respawn = row.get("respawn")
+            labels[row["frame"]] = {
+                "health": health,
+                "dead": bool(int(dead)) if dead not in (None, "") else health <= 0.0,
+                "respawn": bool(int(respawn)) if respawn not in (None, "") else None,
+            }
+    return labels
+
+
+class DetectorStats:
+    """Latency samples and accuracy counters for one detector"""
+
+    def __init__(self):
+        self.latencies = []
+        self.errors = []  # Absolute health errors
+        self.correct = 0
+        self.labeled = 0
+
+    def report(self):
+        result = {"frames": len(self.latencies)}
+        if self.latencies:
+            values = np.array(self.latencies) * 1000.0
+            p50, p95, p99 = np.percentile(values, (50, 95, 99))
+            result.update({
+                "p50_ms": round(float(p50), 3),
+                "p95_ms": round(float(p95), 3),
+                "p99_ms": round(float(p99), 3),
+                "mean_ms": round(float(values.mean()), 3),
+                "fps": round(1000.0 / float(values.mean()), 1) if values.mean() > 0 else None,
+            })
+        if self.errors:
+            result["health_mae"] = round(float(np.mean(self.errors)), 4)
+        if self.labeled:
+            result["accuracy"] = round(self.correct / self.labeled, 4)
+        return result
+
+
+def timed(function, *args):
+    start = time.perf_counter()
+    value = function(*args)
+    return value, time.perf_counter() - start
+
+
+def compare_kernels(automation, frame, native, stats):
+    """Time OpenCV and native correlations of every health template on this frame's search area"""
+    image = automation._health_search_frame(frame).gray
+    worst = 0.0
+    for template in automation.health_templates.values():
+        if image.shape[0] < template.height or image.shape[1] < template.width:
+            continue
+        expected, t_opencv = timed(cv2.matchTemplate, image, template.gray, cv2.TM_CCOEFF_NORMED)
+        result, t_native = timed(native.correlate, image, template.gray)
+        stats["kernel_opencv"].latencies.append(t_opencv)
+        stats["kernel_native"].latencies.append(t_native)
+        worst = max(worst, float(np.abs(expected - result).max()))
+    return worst
+
+
+def run_benchmark(frames_path, labels_path=None, repeat=1, warmup=3, matcher="auto", gpu="off", gates=False):
+    labels = load_labels(labels_path)
+    replay = ReplayCapture()
+    automation = GameAutomation(
+        pipelined=False, metrics_interval=0, capture_backend=replay, record_seconds=0,
+        matcher_backend=matcher, gpu=gpu,
+    )
+    stats = {name: DetectorStats() for name in DETECTORS}
+    stats["convert"] = DetectorStats()
+    native = NativeKernel() if fastmatch is not None else None
+    kernel_diff = 0.0
+    if native is not None:
+        stats["kernel_opencv"] = DetectorStats()
+        stats["kernel_native"] = DetectorStats()
+
+    frames = list(load_frames(frames_path))
+    if not frames:
+        raise RuntimeError(f"No frames found in {frames_path}")
+    print(f"Replaying {len(frames)} frame(s) x{repeat} from {frames_path}")
+
+    processed = 0
+    wall_start = time.perf_counter()
+    for _ in range(repeat):
+        for frame_id, image in frames:
+            replay.set_frame(image)
+            frame = Frame.capture(replay)
+            label = labels.get(frame_id)
+            record = processed >= warmup
+            processed += 1
+            if not gates:
+                # Replayed frames are near-identical and close in time, a live gate would
+                # time its cached result instead of the detector
+                automation.health_gate.reset()
+                automation.respawn_gate.reset()
+
+            # Conversions are shared by every detector in a live tick, time them once
+            _, convert_time = timed(lambda: (frame.gray, frame.bgr))
+
+            template_health, t_template = timed(automation.match_health_template, frame.gray)
+            health, t_health = timed(automation.get_health_percentage, frame)
+            empty, t_empty = timed(automation.is_health_empty, frame)
+            (respawn, _), t_respawn = timed(automation.detect_respawn_button, frame)
+
+            if not record:
+                continue
+            if native is not None:
+                kernel_diff = max(kernel_diff, compare_kernels(automation, frame, native, stats))
+            stats["convert"].latencies.append(convert_time)
+            for name, elapsed in (
+                ("match_health_template", t_template),
+                ("get_health_percentage", t_health),
+                ("is_health_empty", t_empty),
+                ("detect_respawn_button", t_respawn),
+            ):
+                stats[name].latencies.append(elapsed)
+
+            if label is None:
+                continue
+            for name, value in (("match_health_template", template_health), ("get_health_percentage", health)):
+                stats[name].errors.append(abs(value - label["health"]))
+                stats[name].labeled += 1
+                # Counted correct when it lands on the same side of the potion threshold
+                expected_potion = label["health"] <= automation.health_threshold
+                stats[name].correct += int((value <= automation.health_threshold) == expected_potion)
+            stats["is_health_empty"].labeled += 1
+            stats["is_health_empty"].correct += int(empty == label["dead"])
+            if label["respawn"] is not None:
+                stats["detect_respawn_button"].labeled += 1
+                stats["detect_respawn_button"].correct += int(respawn == label["respawn"])
+
+    wall_time = time.perf_counter() - wall_start
+    results = {name: s.report() for name, s in stats.items()}
+    results["_total"] = {
+        "frames": processed - min(processed, warmup),
+        "wall_s": round(wall_time, 3),
+        "fps": round(processed / wall_time, 1) if wall_time > 0 else None,
+        "roi_locked": automation.health_roi.locked,
+        "matcher": automation.pyramid_matcher.backend,
+        "change_gates": gates,
+    }
+    if native is not None:
+        results["_total"]["kernel_max_diff"] = round(kernel_diff, 6)
+    return results
+
+
+def print_results(results, baseline=None):
+    print("\n=== Detector Benchmark ===")
+    header = f"{'detector':<24}{'p50 ms':>9}{'p95 ms':>9}{'p99 ms':>9}{'fps':>9}{'MAE':>8}{'acc':>8}"
+    print(header)
+    print("-" * len(header))
+    for name, r in results.items():
+        if name.startswith("_"):
+            continue
+        line = (
+            f"{name:<24}{r.get('p50_ms', 0):>9.3f}{r.get('p95_ms', 0):>9.3f}{r.get('p99_ms', 0):>9.3f}"
+            f"{r.get('fps') or 0:>9.1f}"
+        )
+        line += f"{r['health_mae']:>8.3f}" if "health_mae" in r else f"{'-':>8}"
+        line += f"{r['accuracy']:>8.1%}" if "accuracy" in r else f"{'-':>8}"
+        if baseline and name in baseline and "p50_ms" in baseline[name] and r.get("p50_ms"):
+            speedup = baseline[name]["p50_ms"] / r["p50_ms"] if r["p50_ms"] else 0
+            line += f"   ({speedup:.2f}x vs baseline p50)"
+        print(line)
+    total = results["_total"]
+    print(f"\nTotal: {total['frames']} frames in {total['wall_s']}s ({total['fps']} frames/sec), "
+          f"ROI locked: {total['roi_locked']}, matcher: {total['matcher']}, "
+          f"change gates: {'on' if total.get('change_gates') else 'off (reset every frame)'}")
+    if "kernel_max_diff" in total:
+        print(f"Native vs OpenCV kernel: max score difference {total['kernel_max_diff']}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay recorded frames through the detectors")
+    parser.add_argument("frames", help="Directory of frame images or a video file")
+    parser.add_argument("--labels", help="CSV with frame,health[,dead][,respawn] columns")
+    parser.add_argument("--repeat", type=int, default=1, help="Replay the frames N times (default: 1)")
+    parser.add_argument("--warmup", type=int, default=3, help="Frames excluded from the stats (default: 3)")
+    parser.add_argument("--gates", action="store_true",
+                        help="Keep the change gates live, timing cached results of unchanged frames too")
+    parser.add_argument("--output", help="Write the results as JSON to this file")
+    parser.add_argument("--baseline", help="JSON results of a previous run to compare against")
+    parser.add_argument("--matcher", choices=MATCHER_BACKENDS, default="auto",
+                        help="Matching kernel used by the detectors (default: auto)")
+    parser.add_argument("--gpu", choices=GPU_BACKENDS, default="off",
+                        help="GPU backend for full-screen searches (default: off)")
+    args = parser.parse_args()
+
+    results = run_benchmark(args.frames, args.labels, args.repeat, args.warmup, args.matcher, args.gpu, args.gates)
+
+    baseline = None
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    print_results(results, baseline)
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2)
+        print(f"Results written to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,110 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Calibration cache and threshold tuning.
+Detector scores are collected over a session; thresholds are fitted from
+their distributions and saved with the locked ROIs and UI scale, so the next
+start can go straight to the ROI path with thresholds tuned for this setup.
+"""
+
+import json
+import os
+import time
+from collections import deque
+
+import numpy as np
+
+CACHE_VERSION = 1
+
+
+class ScoreRecorder:
+    """Last `maxlen` scores of every detector"""
+
+    def __init__(self, maxlen=5000):
+        self.maxlen = maxlen
+        self._scores = {}
+
+    def record(self, name, score):
+        scores = self._scores.get(name)
+        if scores is None:
+            scores = self._scores[name] = deque(maxlen=self.maxlen)
+        scores.append(float(score))
+
+    def scores(self, name):
+        return np.fromiter(self._scores.get(name, ()), dtype=np.float64)
+
+    def names(self):
+        return list(self._scores)
+
+    def clear(self):
+        self._scores.clear()
+
+
+def otsu_split(scores, bins=100):
+    """Score that best separates two modes (max between-class variance) over [0, 1]"""
+    histogram, edges = np.histogram(np.clip(scores, 0.0, 1.0), bins=bins, range=(0.0, 1.0))
+    centres = (edges[:-1] + edges[1:]) / 2
+    weights = np.cumsum(histogram)
+    sums = np.cumsum(histogram * centres)
+    total, total_sum = weights[-1], sums[-1]
+    low_weight = weights[:-1]
+    high_weight = total - low_weight
+    valid = (low_weight > 0) & (high_weight > 0)
+    if not valid.any():
+        return None
+    low_mean = np.where(valid, sums[:-1] / np.maximum(low_weight, 1), 0.0)
+    high_mean = np.where(valid, (total_sum - sums[:-1]) / np.maximum(high_weight, 1), 0.0)
+    between = np.where(valid, low_weight * high_weight * (low_mean - high_mean) ** 2, -1.0)
+    return float(edges[int(np.argmax(between)) + 1])
+
+
+def fit_separation(scores, min_count=20, min_gap=0.1):
+    """Threshold in the middle of the gap between absent and present scores, None without a clean gap"""
+    if len(scores) < 2 * min_count:
+        return None
+    split = otsu_split(scores)
+    if split is None:
+        return None
+    low, high = scores[scores < split], scores[scores >= split]
+    if len(low) < min_count or len(high) < min_count:
+        return None
+    # Ignore the odd outlier on either side when measuring the gap
+    low_edge, high_edge = np.percentile(low, 99), np.percentile(high, 1)
+    if high_edge - low_edge < min_gap:
+        return None
+    return float((low_edge + high_edge) / 2)
+
+
+def fit_floor(scores, percentile=1.0, margin=0.05, min_count=50):
+    """A bound just under the weakest scores of an always-present element, None without enough data"""
+    if len(scores) < min_count:
+        return None
+    return float(np.percentile(scores, percentile) - margin)
+
+
+class CalibrationCache:
+    """JSON file with the locked ROIs, UI scale and tuned thresholds of one capture setup"""
+
+    def __init__(self, path):
+        self.path = path
+
+    def load(self, screen_size, capture_name):
+        """Cached calibration for this screen size and capture backend, None when missing or stale"""
+        try:
+            with open(self.path) as f:
+                data = json.load(f)
+        except (OSError, ValueError):
+            return None
+        if data.get("version") != CACHE_VERSION:
+            return None
+        if tuple(data.get("screen_size", ())) != tuple(screen_size) or data.get("capture") != capture_name:
+            return None
+        return data
+
+    def save(self, data):
+        data = dict(data, version=CACHE_VERSION, saved=time.time())
+        os.makedirs(os.path.dirname(self.path) or ".", exist_ok=True)
+        # Write then rename so a concurrent start never reads a half-written file
+        with open(self.path + ".tmp", "w") as f:
+            json.dump(data, f, indent=2)
+        os.replace(self.path + ".tmp", self.path)
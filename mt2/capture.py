@@ -0,0 +1,1000 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+In-memory screen capture backends.
+Every backend returns a BGRA numpy array (height, width, 4) without spawning
+processes or touching the disk. The returned array may be a buffer that is
+reused by the next grab() call, copy it if you need to keep it.
+Window captures also hand out a key sender for their window (key_sender()),
+so several clients each get their own keys instead of the focused one's.
+"""
+
+import ctypes
+import ctypes.util
+import platform
+import threading
+import time
+
+import numpy as np
+
+
+class CaptureBackend:
+    """Base class for screen capture backends"""
+
+    name = "base"
+
+    def grab(self, region=None):
+        """Grab the screen (or an (x, y, width, height) region) as a BGRA array"""
+        raise NotImplementedError
+
+    def screen_size(self):
+        """Return (width, height) of the captured screen"""
+        raise NotImplementedError
+
+    def close(self):
+        """Release any native resources"""
+
+
+# --- X11 (Linux) -------------------------------------------------------------
+
+class _XImage(ctypes.Structure):
+    _fields_ = [
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("xoffset", ctypes.c_int),
+        ("format", ctypes.c_int),
+        ("data", ctypes.c_void_p),
+        ("byte_order", ctypes.c_int),
+        ("bitmap_unit", ctypes.c_int),
+        ("bitmap_bit_order", ctypes.c_int),
+        ("bitmap_pad", ctypes.c_int),
+        ("depth", ctypes.c_int),
+        ("bytes_per_line", ctypes.c_int),
+        ("bits_per_pixel", ctypes.c_int),
+        ("red_mask", ctypes.c_ulong),
+        ("green_mask", ctypes.c_ulong),
+        ("blue_mask", ctypes.c_ulong),
+        ("obdata", ctypes.c_void_p),
+        # struct funcs: create_image, destroy_image, get_pixel, put_pixel, sub_image, add_pixel
+        ("f_create_image", ctypes.c_void_p),
+        ("f_destroy_image", ctypes.c_void_p),
+        ("f_get_pixel", ctypes.c_void_p),
+        ("f_put_pixel", ctypes.c_void_p),
+        ("f_sub_image", ctypes.c_void_p),
+        ("f_add_pixel", ctypes.c_void_p),
+    ]
+
+
+class _XShmSegmentInfo(ctypes.Structure):
+    _fields_ = [
+        ("shmseg", ctypes.c_ulong),
+        ("shmid", ctypes.c_int),
+        ("shmaddr", ctypes.c_void_p),
+        ("readOnly", ctypes.c_int),
+    ]
+
+
+_ZPIXMAP = 2
+_ALL_PLANES = 0xFFFFFFFFFFFFFFFF if ctypes.sizeof(ctypes.c_ulong) == 8 else 0xFFFFFFFF
+_IPC_PRIVATE = 0
+_IPC_CREAT = 0o1000
+_IPC_RMID = 0
+_SHMAT_FAILED = ctypes.c_void_p(-1).value  # (void*)-1
+_DESTROY_IMAGE = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.POINTER(_XImage))
+
+
+class X11Capture(CaptureBackend):
+    """Capture the X11 root window with MIT-SHM (XShmGetImage), falling back to XGetImage.
+
+    With MIT-SHM the X server writes pixels straight into a shared memory segment
+    that is exposed as a numpy view, so a grab is a single round trip and no copy.
+    One segment is kept per region size, which suits the fixed ROIs used per tick.
+    Xlib calls are not thread-safe here: use one instance per thread.
+    """
+
+    name = "x11"
+
+    def __init__(self, use_shm=True):
+        xlib_path = ctypes.util.find_library("X11")
+        if not xlib_path:
+            raise RuntimeError("libX11 not found")
+        self._xlib = ctypes.cdll.LoadLibrary(xlib_path)
+        self._setup_prototypes()
+
+        _init_x_threads(self._xlib)
+        self._display = self._xlib.XOpenDisplay(None)
+        if not self._display:
+            raise RuntimeError("Cannot open X display (is DISPLAY set?)")
+
+        screen = self._xlib.XDefaultScreen(self._display)
+        self._root = self._xlib.XDefaultRootWindow(self._display)
+        self._drawable = self._root  # What grab() reads from
+        self._visual = self._xlib.XDefaultVisual(self._display, screen)
+        self._depth = self._xlib.XDefaultDepth(self._display, screen)
+        self._width = self._xlib.XDisplayWidth(self._display, screen)
+        self._height = self._xlib.XDisplayHeight(self._display, screen)
+
+        self._xext = None
+        self._libc = None
+        self._use_shm = False
+        self._shm_images = {}  # (width, height) -> (XImage*, segment info, numpy view)
+        self._buffers = {}  # (width, height) -> reusable array for the XGetImage path
+        if use_shm:
+            self._init_shm()
+
+    def _setup_prototypes(self):
+        x = self._xlib
+        x.XOpenDisplay.restype = ctypes.c_void_p
+        x.XOpenDisplay.argtypes = [ctypes.c_char_p]
+        x.XDefaultScreen.argtypes = [ctypes.c_void_p]
+        x.XDefaultRootWindow.restype = ctypes.c_ulong
+        x.XDefaultRootWindow.argtypes = [ctypes.c_void_p]
+        x.XDefaultVisual.restype = ctypes.c_void_p
+        x.XDefaultVisual.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        x.XDefaultDepth.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        x.XDisplayWidth.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        x.XDisplayHeight.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        x.XGetImage.restype = ctypes.POINTER(_XImage)
+        x.XGetImage.argtypes = [
+            ctypes.c_void_p, ctypes.c_ulong, ctypes.c_int, ctypes.c_int,
+            ctypes.c_uint, ctypes.c_uint, ctypes.c_ulong, ctypes.c_int,
+        ]
+        x.XSync.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        x.XInitThreads.restype = ctypes.c_int
+        x.XInitThreads.argtypes = []
+        x.XFree.argtypes = [ctypes.c_void_p]
+        x.XCloseDisplay.argtypes = [ctypes.c_void_p]
+
+    def _init_shm(self):
+        """Load libXext/libc for MIT-SHM; silently keep XGetImage if unavailable"""
+        xext_path = ctypes.util.find_library("Xext")
+        libc_path = ctypes.util.find_library("c")
+        if not xext_path or not libc_path:
+            return
+        try:
+            xext = ctypes.cdll.LoadLibrary(xext_path)
+            libc = ctypes.cdll.LoadLibrary(libc_path)
+        except OSError:
+            return
+
+        xext.XShmQueryExtension.argtypes = [ctypes.c_void_p]
+        if not xext.XShmQueryExtension(self._display):
+            return
+
+        xext.XShmCreateImage.restype = ctypes.POINTER(_XImage)
+        xext.XShmCreateImage.argtypes = [
+            ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint, ctypes.c_int,
+            ctypes.c_void_p, ctypes.POINTER(_XShmSegmentInfo), ctypes.c_uint, ctypes.c_uint,
+        ]
+        xext.XShmAttach.argtypes = [ctypes.c_void_p, ctypes.POINTER(_XShmSegmentInfo)]
+        xext.XShmDetach.argtypes = [ctypes.c_void_p, ctypes.POINTER(_XShmSegmentInfo)]
+        xext.XShmGetImage.argtypes = [
+            ctypes.c_void_p, ctypes.c_ulong, ctypes.POINTER(_XImage),
+            ctypes.c_int, ctypes.c_int, ctypes.c_ulong,
+        ]
+        libc.shmget.argtypes = [ctypes.c_int, ctypes.c_size_t, ctypes.c_int]
+        libc.shmat.restype = ctypes.c_void_p
+        libc.shmat.argtypes = [ctypes.c_int, ctypes.c_void_p, ctypes.c_int]
+        libc.shmdt.argtypes = [ctypes.c_void_p]
+        libc.shmctl.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_void_p]
+
+        self._xext = xext
+        self._libc = libc
+        self._use_shm = True
+
+    @property
+    def uses_shm(self):
+        return self._use_shm
+
+    def screen_size(self):
+        return self._width, self._height
+
+    def _clip(self, region):
+        if region is None:
+            return 0, 0, self._width, self._height
+        x, y, w, h = (int(v) for v in region)
+        x = max(0, min(x, self._width - 1))
+        y = max(0, min(y, self._height - 1))
+        w = max(1, min(w, self._width - x))
+        h = max(1, min(h, self._height - y))
+        return x, y, w, h
+
+    def _shm_image(self, width, height):
+        """Create (once) a shared memory XImage of the given size"""
+        key = (width, height)
+        entry = self._shm_images.get(key)
+        if entry is not None:
+            return entry
+
+        info = _XShmSegmentInfo()
+        image = self._xext.XShmCreateImage(
+            self._display, self._visual, self._depth, _ZPIXMAP, None,
+            ctypes.byref(info), width, height,
+        )
+        if not image:
+            raise RuntimeError("XShmCreateImage failed")
+
+        size = image.contents.bytes_per_line * image.contents.height
+        info.shmid = self._libc.shmget(_IPC_PRIVATE, size, _IPC_CREAT | 0o600)
+        if info.shmid < 0:
+            self._xlib.XFree(image)
+            raise RuntimeError("shmget failed")
+        info.shmaddr = self._libc.shmat(info.shmid, None, 0)
+        if info.shmaddr in (None, _SHMAT_FAILED):
+            # shmat returns (void*)-1 on failure, never hand that to XShmAttach or numpy
+            self._libc.shmctl(info.shmid, _IPC_RMID, None)
+            self._xlib.XFree(image)
+            raise RuntimeError("shmat failed")
+        image.contents.data = info.shmaddr
+        info.readOnly = 0
+        if not self._xext.XShmAttach(self._display, ctypes.byref(info)):
+            self._release_segment(info)
+            self._xlib.XFree(image)
+            raise RuntimeError("XShmAttach failed")
+        self._xlib.XSync(self._display, 0)
+        # Mark for removal now so the segment is freed even if we crash
+        self._libc.shmctl(info.shmid, _IPC_RMID, None)
+
+        view = self._as_array(image.contents, size)
+        entry = (image, info, view)
+        self._shm_images[key] = entry
+        return entry
+
+    def _release_segment(self, info):
+        self._libc.shmdt(info.shmaddr)
+        self._libc.shmctl(info.shmid, _IPC_RMID, None)
+
+    @staticmethod
+    def _as_array(ximage, size):
+        """Expose XImage pixel memory as a (height, width, 4) uint8 view"""
+        if ximage.bits_per_pixel != 32:
+            raise RuntimeError(f"Unsupported X11 pixel format: {ximage.bits_per_pixel} bpp")
+        raw = (ctypes.c_ubyte * size).from_address(ximage.data)
+        rows = np.frombuffer(raw, dtype=np.uint8).reshape(ximage.height, ximage.bytes_per_line)
+        return rows[:, : ximage.width * 4].reshape(ximage.height, ximage.width, 4)
+
+    def grab(self, region=None):
+        x, y, w, h = self._clip(region)
+        if self._use_shm:
+            try:
+                image, _, view = self._shm_image(w, h)
+                if self._xext.XShmGetImage(self._display, self._drawable, image, x, y, _ALL_PLANES):
+                    return view
+            except RuntimeError:
+                # Some servers (e.g. remote displays) refuse SHM, use the plain path from now on
+                self._use_shm = False
+        return self._grab_xgetimage(x, y, w, h)
+
+    def _grab_xgetimage(self, x, y, w, h):
+        image = self._xlib.XGetImage(self._display, self._drawable, x, y, w, h, _ALL_PLANES, _ZPIXMAP)
+        if not image:
+            raise RuntimeError("XGetImage failed")
+        try:
+            ximage = image.contents
+            view = self._as_array(ximage, ximage.bytes_per_line * ximage.height)
+            buffer = self._buffers.get((w, h))
+            if buffer is None:
+                buffer = np.empty((h, w, 4), dtype=np.uint8)
+                self._buffers[(w, h)] = buffer
+            np.copyto(buffer, view)
+            return buffer
+        finally:
+            _DESTROY_IMAGE(image.contents.f_destroy_image)(image)
+
+    def _release_shm_images(self):
+        for image, info, _ in self._shm_images.values():
+            self._xext.XShmDetach(self._display, ctypes.byref(info))
+            self._release_segment(info)
+            image.contents.data = None
+            self._xlib.XFree(image)
+        self._shm_images.clear()
+        self._buffers.clear()
+
+    def close(self):
+        if not self._display:
+            return
+        self._release_shm_images()
+        self._xlib.XCloseDisplay(self._display)
+        self._display = None
+
+
+class _XWindowAttributes(ctypes.Structure):
+    _fields_ = [
+        ("x", ctypes.c_int),
+        ("y", ctypes.c_int),
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("border_width", ctypes.c_int),
+        ("depth", ctypes.c_int),
+        ("visual", ctypes.c_void_p),
+        ("root", ctypes.c_ulong),
+        ("c_class", ctypes.c_int),
+        ("bit_gravity", ctypes.c_int),
+        ("win_gravity", ctypes.c_int),
+        ("backing_store", ctypes.c_int),
+        ("backing_planes", ctypes.c_ulong),
+        ("backing_pixel", ctypes.c_ulong),
+        ("save_under", ctypes.c_int),
+        ("colormap", ctypes.c_ulong),
+        ("map_installed", ctypes.c_int),
+        ("map_state", ctypes.c_int),
+        ("all_event_masks", ctypes.c_long),
+        ("your_event_mask", ctypes.c_long),
+        ("do_not_propagate_mask", ctypes.c_long),
+        ("override_redirect", ctypes.c_int),
+        ("screen", ctypes.c_void_p),
+    ]
+
+
+class _XErrorEvent(ctypes.Structure):
+    _fields_ = [
+        ("type", ctypes.c_int),
+        ("display", ctypes.c_void_p),
+        ("resourceid", ctypes.c_ulong),
+        ("serial", ctypes.c_ulong),
+        ("error_code", ctypes.c_ubyte),
+        ("request_code", ctypes.c_ubyte),
+        ("minor_code", ctypes.c_ubyte),
+    ]
+
+
+_IS_VIEWABLE = 2
+_COMPOSITE_REDIRECT_AUTOMATIC = 0
+_X_ERROR_HANDLER = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.POINTER(_XErrorEvent))
+
+# The error handler is process-wide, so errors are kept per Display connection: several window
+# captures grabbing on different threads only ever see their own
+_x_errors = {}  # Display pointer -> error codes since its last check (Xlib would exit the process otherwise)
+_x_lock = threading.Lock()
+_x_threads_initialised = False
+_x_handler_installed = False
+
+
+def _init_x_threads(xlib):
+    """XInitThreads, which must come before the first XOpenDisplay, so displays can be used from any thread"""
+    global _x_threads_initialised
+    with _x_lock:
+        if not _x_threads_initialised:
+            xlib.XInitThreads()
+            _x_threads_initialised = True
+
+
+def _install_x_error_handler(xlib):
+    global _x_handler_installed
+    with _x_lock:
+        if not _x_handler_installed:
+            xlib.XSetErrorHandler(_record_x_error)
+            _x_handler_installed = True
+
+
+@_X_ERROR_HANDLER
+def _record_x_error(display, event):
+    with _x_lock:
+        _x_errors.setdefault(event.contents.display, []).append(event.contents.error_code)
+    return 0
+
+
+def _take_x_errors(display):
+    """Error codes raised on `display` since the last call"""
+    with _x_lock:
+        return _x_errors.pop(display, [])
+
+
+class X11WindowCapture(X11Capture):
+    """Capture one X11 window's own drawable, by window ID or title.
+
+    Only the window's pixels cross the wire, and with XComposite the window is
+    redirected to an offscreen pixmap, so it can be read while covered by other
+    windows or on another monitor. Minimised (unmapped) windows have no pixels.
+    Regions are in window coordinates; window_origin() maps them to the screen.
+    """
+
+    name = "x11-window"
+
+    def __init__(self, window, use_shm=True, redirect=True):
+        super().__init__(use_shm=use_shm)
+        self._setup_window_prototypes()
+        _install_x_error_handler(self._xlib)
+
+        self._window = self._resolve_window(window)
+        self._drawable = self._window
+        self._composite = None
+        if redirect:
+            self._redirect()
+        self._refresh_geometry()
+
+    def _setup_window_prototypes(self):
+        x = self._xlib
+        x.XSetErrorHandler.restype = ctypes.c_void_p
+        x.XSetErrorHandler.argtypes = [_X_ERROR_HANDLER]
+        x.XGetWindowAttributes.argtypes = [ctypes.c_void_p, ctypes.c_ulong, ctypes.POINTER(_XWindowAttributes)]
+        x.XQueryTree.argtypes = [
+            ctypes.c_void_p, ctypes.c_ulong, ctypes.POINTER(ctypes.c_ulong), ctypes.POINTER(ctypes.c_ulong),
+            ctypes.POINTER(ctypes.POINTER(ctypes.c_ulong)), ctypes.POINTER(ctypes.c_uint),
+        ]
+        x.XFetchName.argtypes = [ctypes.c_void_p, ctypes.c_ulong, ctypes.POINTER(ctypes.c_char_p)]
+        x.XTranslateCoordinates.argtypes = [
+            ctypes.c_void_p, ctypes.c_ulong, ctypes.c_ulong, ctypes.c_int, ctypes.c_int,
+            ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_ulong),
+        ]
+
+    def _resolve_window(self, window):
+        """Window ID (int or "0x..." string) or the first viewable window whose title contains `window`"""
+        if isinstance(window, int):
+            return window
+        try:
+            return int(window, 0)
+        except ValueError:
+            pass
+        matches = [w for w, title in self._windows(self._root) if window in title]
+        if not matches:
+            raise RuntimeError(f"No X11 window titled '{window}'")
+        viewable = [w for w in matches if self._attributes(w).map_state == _IS_VIEWABLE]
+        return (viewable or matches)[0]
+
+    def _windows(self, parent):
+        """(window, title) of every named window below `parent`, depth first"""
+        root, parent_out = ctypes.c_ulong(), ctypes.c_ulong()
+        children, count = ctypes.POINTER(ctypes.c_ulong)(), ctypes.c_uint()
+        if not self._xlib.XQueryTree(self._display, parent, ctypes.byref(root), ctypes.byref(parent_out),
+                                     ctypes.byref(children), ctypes.byref(count)):
+            return
+        try:
+            ids = [children[i] for i in range(count.value)]
+        finally:
+            if children:
+                self._xlib.XFree(children)
+        for window in ids:
+            name = ctypes.c_char_p()
+            if self._xlib.XFetchName(self._display, window, ctypes.byref(name)) and name.value:
+                title = name.value.decode("utf-8", "replace")
+                self._xlib.XFree(name)
+                yield window, title
+            yield from self._windows(window)
+
+    def _attributes(self, window):
+        attributes = _XWindowAttributes()
+        if not self._xlib.XGetWindowAttributes(self._display, window, ctypes.byref(attributes)):
+            raise RuntimeError(f"X11 window 0x{window:x} is gone")
+        return attributes
+
+    def _redirect(self):
+        """Keep the window's contents in an offscreen pixmap (no-op without XComposite)"""
+        path = ctypes.util.find_library("Xcomposite")
+        if not path:
+            return
+        try:
+            composite = ctypes.cdll.LoadLibrary(path)
+        except OSError:
+            return
+        composite.XCompositeQueryExtension.argtypes = [
+            ctypes.c_void_p, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int),
+        ]
+        composite.XCompositeRedirectWindow.argtypes = [ctypes.c_void_p, ctypes.c_ulong, ctypes.c_int]
+        composite.XCompositeUnredirectWindow.argtypes = [ctypes.c_void_p, ctypes.c_ulong, ctypes.c_int]
+        event_base, error_base = ctypes.c_int(), ctypes.c_int()
+        if not composite.XCompositeQueryExtension(self._display, ctypes.byref(event_base), ctypes.byref(error_base)):
+            return
+        composite.XCompositeRedirectWindow(self._display, self._window, _COMPOSITE_REDIRECT_AUTOMATIC)
+        self._xlib.XSync(self._display, 0)
+        self._composite = composite
+
+    def _refresh_geometry(self):
+        """Re-read size, depth and visual (windows of another depth than the root need their own)"""
+        attributes = self._attributes(self._window)
+        if (attributes.width, attributes.height) != (self._width, self._height) or attributes.depth != self._depth:
+            # Segments of the old size will not be asked for again
+            self._release_shm_images()
+        self._width, self._height = attributes.width, attributes.height
+        self._depth = attributes.depth
+        self._visual = attributes.visual
+        self._viewable = attributes.map_state == _IS_VIEWABLE
+
+    def window_origin(self):
+        """Screen position of the window's (0, 0), for clicks"""
+        x, y, child = ctypes.c_int(), ctypes.c_int(), ctypes.c_ulong()
+        self._xlib.XTranslateCoordinates(self._display, self._window, self._root, 0, 0,
+                                         ctypes.byref(x), ctypes.byref(y), ctypes.byref(child))
+        return x.value, y.value
+
+    def grab(self, region=None):
+        _take_x_errors(self._display)
+        try:
+            frame = super().grab(region)
+            if not _take_x_errors(self._display):
+                return frame
+        except RuntimeError:
+            pass
+        # Resized, unmapped or destroyed since the last grab: re-read it and try once more
+        _take_x_errors(self._display)
+        self._refresh_geometry()
+        if not self._viewable:
+            raise RuntimeError(f"X11 window 0x{self._window:x} is not mapped (minimised?)")
+        frame = super().grab(region)
+        errors = _take_x_errors(self._display)
+        if errors:
+            raise RuntimeError(f"Cannot read X11 window 0x{self._window:x} (X error {errors[-1]})")
+        return frame
+
+    def close(self):
+        if self._display and self._composite is not None:
+            self._composite.XCompositeUnredirectWindow(self._display, self._window, _COMPOSITE_REDIRECT_AUTOMATIC)
+        _take_x_errors(self._display)
+        super().close()
+
+    def key_sender(self):
+        """X11WindowKeys typing into this window"""
+        return X11WindowKeys(self._xlib, self._window)
+
+
+_REVERT_TO_PARENT = 2
+_x_focus_lock = threading.Lock()  # Focus, press and release of one key never interleave with another client's
+
+
+class X11WindowKeys:
+    """Key presses for one X11 window: focus it, type through XTest, give the focus back.
+
+    XTest events go to the focused window like real ones (synthetic
+    XSendEvent events are ignored by most games), so the focus switch and the
+    press run under a process-wide lock. Keys use their own connection, so
+    their X errors never mix with the capture's.
+    """
+
+    def __init__(self, xlib, window):
+        path = ctypes.util.find_library("Xtst")
+        if not path:
+            raise RuntimeError("libXtst not found, cannot send keys to a single window")
+        self._xtst = ctypes.cdll.LoadLibrary(path)
+        self._xtst.XTestFakeKeyEvent.argtypes = [ctypes.c_void_p, ctypes.c_uint, ctypes.c_int, ctypes.c_ulong]
+        self._xlib = xlib
+        xlib.XStringToKeysym.restype = ctypes.c_ulong
+        xlib.XStringToKeysym.argtypes = [ctypes.c_char_p]
+        xlib.XKeysymToKeycode.restype = ctypes.c_ubyte
+        xlib.XKeysymToKeycode.argtypes = [ctypes.c_void_p, ctypes.c_ulong]
+        xlib.XGetInputFocus.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_ulong), ctypes.POINTER(ctypes.c_int)]
+        xlib.XSetInputFocus.argtypes = [ctypes.c_void_p, ctypes.c_ulong, ctypes.c_int, ctypes.c_ulong]
+        xlib.XFlush.argtypes = [ctypes.c_void_p]
+        _init_x_threads(xlib)
+        self._display = xlib.XOpenDisplay(None)
+        if not self._display:
+            raise RuntimeError("Cannot open X display for key input")
+        _install_x_error_handler(xlib)
+        self._window = window
+        self._keycodes = {}
+
+    def close(self):
+        if self._display:
+            _take_x_errors(self._display)
+            self._xlib.XCloseDisplay(self._display)
+            self._display = None
+
+    def _keycode(self, key):
+        keycode = self._keycodes.get(key)
+        if keycode is None:
+            keycode = self._xlib.XKeysymToKeycode(self._display, self._xlib.XStringToKeysym(str(key).encode()))
+            if not keycode:
+                raise ValueError(f"No X11 keycode for key '{key}'")
+            self._keycodes[key] = keycode
+        return keycode
+
+    def tap(self, key, duration):
+        keycode = self._keycode(key)
+        with _x_focus_lock:
+            previous, revert = ctypes.c_ulong(), ctypes.c_int()
+            self._xlib.XGetInputFocus(self._display, ctypes.byref(previous), ctypes.byref(revert))
+            self._xlib.XSetInputFocus(self._display, self._window, _REVERT_TO_PARENT, 0)
+            self._xlib.XSync(self._display, 0)
+            try:
+                self._xtst.XTestFakeKeyEvent(self._display, keycode, 1, 0)
+                self._xlib.XFlush(self._display)
+                time.sleep(duration)
+                self._xtst.XTestFakeKeyEvent(self._display, keycode, 0, 0)
+            finally:
+                if previous.value and previous.value != self._window:
+                    self._xlib.XSetInputFocus(self._display, previous.value, revert.value, 0)
+                self._xlib.XSync(self._display, 0)
+        errors = _take_x_errors(self._display)
+        if errors:
+            raise RuntimeError(f"Cannot send key '{key}' to X11 window 0x{self._window:x} (X error {errors[-1]})")
+
+
+# --- Native APIs via mss (Windows GDI, macOS CoreGraphics) -----------------------
+
+class MssCapture(CaptureBackend):
+    """Capture through mss, which wraps BitBlt on Windows and CoreGraphics on macOS"""
+
+    name = "mss"
+
+    def __init__(self):
+        import mss
+
+        self._sct = mss.mss()
+        # monitors[0] is the union of all monitors, same area scrot used to capture
+        self._monitor = dict(self._sct.monitors[0])
+
+    def screen_size(self):
+        return self._monitor["width"], self._monitor["height"]
+
+    def grab(self, region=None):
+        if region is None:
+            box = self._monitor
+        else:
+            x, y, w, h = (int(v) for v in region)
+            box = {
+                "left": self._monitor["left"] + x,
+                "top": self._monitor["top"] + y,
+                "width": w,
+                "height": h,
+            }
+        shot = self._sct.grab(box)
+        # shot.raw is already BGRA, wrap it without copying
+        return np.frombuffer(shot.raw, dtype=np.uint8).reshape(shot.height, shot.width, 4)
+
+    def close(self):
+        self._sct.close()
+
+
+class _BitmapInfoHeader(ctypes.Structure):
+    _fields_ = [
+        ("biSize", ctypes.c_uint32),
+        ("biWidth", ctypes.c_int32),
+        ("biHeight", ctypes.c_int32),
+        ("biPlanes", ctypes.c_uint16),
+        ("biBitCount", ctypes.c_uint16),
+        ("biCompression", ctypes.c_uint32),
+        ("biSizeImage", ctypes.c_uint32),
+        ("biXPelsPerMeter", ctypes.c_int32),
+        ("biYPelsPerMeter", ctypes.c_int32),
+        ("biClrUsed", ctypes.c_uint32),
+        ("biClrImportant", ctypes.c_uint32),
+    ]
+
+
+class _Rect(ctypes.Structure):
+    _fields_ = [("left", ctypes.c_long), ("top", ctypes.c_long), ("right", ctypes.c_long), ("bottom", ctypes.c_long)]
+
+
+class _Point(ctypes.Structure):
+    _fields_ = [("x", ctypes.c_long), ("y", ctypes.c_long)]
+
+
+_PW_CLIENTONLY = 0x1
+_PW_RENDERFULLCONTENT = 0x2  # Windows 8.1+, also renders DirectX/DWM content
+_DIB_RGB_COLORS = 0
+
+
+class Win32WindowCapture(CaptureBackend):
+    """Capture one window's client area with PrintWindow, by HWND or title.
+
+    The window renders itself into a DIB section that is exposed as a numpy view,
+    so it works while the window is covered or in the background. PrintWindow
+    always renders the whole client area; regions are cropped from it.
+    """
+
+    name = "win32-window"
+
+    def __init__(self, window):
+        self._user32 = ctypes.windll.user32
+        self._gdi32 = ctypes.windll.gdi32
+        self._setup_prototypes()
+        self._hwnd = self._resolve_window(window)
+        self._memdc = self._gdi32.CreateCompatibleDC(None)
+        if not self._memdc:
+            raise RuntimeError("CreateCompatibleDC failed")
+        self._bitmap = None
+        self._view = None
+        self._size = (0, 0)
+
+    def _setup_prototypes(self):
+        u, g = self._user32, self._gdi32
+        u.FindWindowW.restype = ctypes.c_void_p
+        u.FindWindowW.argtypes = [ctypes.c_wchar_p, ctypes.c_wchar_p]
+        u.GetWindowTextW.argtypes = [ctypes.c_void_p, ctypes.c_wchar_p, ctypes.c_int]
+        u.IsWindowVisible.argtypes = [ctypes.c_void_p]
+        u.IsWindow.argtypes = [ctypes.c_void_p]
+        u.GetClientRect.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Rect)]
+        u.ClientToScreen.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Point)]
+        u.PrintWindow.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint]
+        g.CreateCompatibleDC.restype = ctypes.c_void_p
+        g.CreateCompatibleDC.argtypes = [ctypes.c_void_p]
+        g.CreateDIBSection.restype = ctypes.c_void_p
+        g.CreateDIBSection.argtypes = [
+            ctypes.c_void_p, ctypes.POINTER(_BitmapInfoHeader), ctypes.c_uint,
+            ctypes.POINTER(ctypes.c_void_p), ctypes.c_void_p, ctypes.c_uint32,
+        ]
+        g.SelectObject.restype = ctypes.c_void_p
+        g.SelectObject.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+        g.DeleteObject.argtypes = [ctypes.c_void_p]
+        g.DeleteDC.argtypes = [ctypes.c_void_p]
+
+    def _resolve_window(self, window):
+        """HWND (int or "0x..." string) or the first visible window whose title contains `window`"""
+        if isinstance(window, int):
+            return window
+        try:
+            return int(window, 0)
+        except ValueError:
+            pass
+        hwnd = self._user32.FindWindowW(None, window)
+        if hwnd:
+            return hwnd
+
+        matches = []
+        title = ctypes.create_unicode_buffer(512)
+
+        @ctypes.WINFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.c_void_p)
+        def visit(handle, _):
+            if self._user32.IsWindowVisible(handle):
+                self._user32.GetWindowTextW(handle, title, len(title))
+                if window in title.value:
+                    matches.append(handle)
+            return 1
+
+        self._user32.EnumWindows(visit, None)
+        if not matches:
+            raise RuntimeError(f"No window titled '{window}'")
+        return matches[0]
+
+    def screen_size(self):
+        rect = _Rect()
+        if not self._user32.GetClientRect(self._hwnd, ctypes.byref(rect)):
+            raise RuntimeError("Window is gone")
+        return rect.right - rect.left, rect.bottom - rect.top
+
+    def window_origin(self):
+        """Screen position of the client area's (0, 0), for clicks"""
+        point = _Point(0, 0)
+        self._user32.ClientToScreen(self._hwnd, ctypes.byref(point))
+        return point.x, point.y
+
+    def _ensure_bitmap(self, width, height):
+        """Top-down 32 bpp DIB section of the client size, recreated on resize"""
+        if self._size == (width, height):
+            return
+        header = _BitmapInfoHeader(
+            biSize=ctypes.sizeof(_BitmapInfoHeader), biWidth=width, biHeight=-height,
+            biPlanes=1, biBitCount=32, biCompression=0,
+        )
+        bits = ctypes.c_void_p()
+        bitmap = self._gdi32.CreateDIBSection(self._memdc, ctypes.byref(header), _DIB_RGB_COLORS,
+                                              ctypes.byref(bits), None, 0)
+        if not bitmap:
+            raise RuntimeError("CreateDIBSection failed")
+        self._gdi32.SelectObject(self._memdc, bitmap)
+        if self._bitmap:
+            self._gdi32.DeleteObject(self._bitmap)
+        self._bitmap = bitmap
+        raw = (ctypes.c_ubyte * (width * height * 4)).from_address(bits.value)
+        self._view = np.frombuffer(raw, dtype=np.uint8).reshape(height, width, 4)
+        self._size = (width, height)
+
+    def grab(self, region=None):
+        width, height = self.screen_size()
+        if width <= 0 or height <= 0:
+            raise RuntimeError("Window has no client area (minimised?)")
+        self._ensure_bitmap(width, height)
+        if not self._user32.PrintWindow(self._hwnd, self._memdc, _PW_CLIENTONLY | _PW_RENDERFULLCONTENT):
+            raise RuntimeError("PrintWindow failed")
+        if region is None:
+            return self._view
+        x, y, w, h = (int(v) for v in region)
+        return self._view[max(0, y): y + h, max(0, x): x + w]
+
+    def close(self):
+        if self._bitmap:
+            self._gdi32.DeleteObject(self._bitmap)
+            self._bitmap = None
+        if self._memdc:
+            self._gdi32.DeleteDC(self._memdc)
+            self._memdc = None
+
+    def key_sender(self):
+        """Win32WindowKeys posting to this window"""
+        return Win32WindowKeys(self._user32, self._hwnd)
+
+
+_WM_KEYDOWN = 0x0100
+_WM_KEYUP = 0x0101
+
+
+class Win32WindowKeys:
+    """Key presses posted to one window's message queue (no focus change).
+
+    Games reading raw input or DirectInput instead of window messages will
+    not see these.
+    """
+
+    def __init__(self, user32, hwnd):
+        user32.VkKeyScanW.restype = ctypes.c_short
+        user32.VkKeyScanW.argtypes = [ctypes.c_wchar]
+        user32.MapVirtualKeyW.restype = ctypes.c_uint
+        user32.MapVirtualKeyW.argtypes = [ctypes.c_uint, ctypes.c_uint]
+        user32.PostMessageW.argtypes = [ctypes.c_void_p, ctypes.c_uint, ctypes.c_size_t, ctypes.c_ssize_t]
+        self._user32 = user32
+        self._hwnd = hwnd
+
+    def tap(self, key, duration):
+        key = str(key)
+        if len(key) != 1:
+            raise ValueError(f"Only single-character keys can be posted to a window, not '{key}'")
+        code = self._user32.VkKeyScanW(key)
+        if code == -1:
+            raise ValueError(f"No virtual key for '{key}'")
+        vk = code & 0xFF
+        scan = self._user32.MapVirtualKeyW(vk, 0)
+        down = 1 | (scan << 16)
+        if not self._user32.PostMessageW(self._hwnd, _WM_KEYDOWN, vk, down):
+            raise RuntimeError("PostMessage failed (window gone?)")
+        time.sleep(duration)
+        self._user32.PostMessageW(self._hwnd, _WM_KEYUP, vk, down | (1 << 30) | (1 << 31))
+
+
+class PyAutoGuiCapture(CaptureBackend):
+    """Last resort in-memory capture through pyautogui (still no temp files)"""
+
+    name = "pyautogui"
+
+    def __init__(self):
+        import cv2
+        import pyautogui
+
+        self._cv2 = cv2
+        self._pyautogui = pyautogui
+
+    def screen_size(self):
+        size = self._pyautogui.size()
+        return size.width, size.height
+
+    def grab(self, region=None):
+        if region is not None:
+            region = tuple(int(v) for v in region)
+        screenshot = self._pyautogui.screenshot(region=region)
+        return self._cv2.cvtColor(np.asarray(screenshot), self._cv2.COLOR_RGB2BGRA)
+
+
+class ReplayCapture(CaptureBackend):
+    """Serve prerecorded frames instead of the live screen (offline benchmarks)"""
+
+    name = "replay"
+
+    def __init__(self, image=None):
+        self._frame = None
+        if image is not None:
+            self.set_frame(image)
+
+    def set_frame(self, image):
+        """Use a BGR, BGRA or grayscale image as the current screen"""
+        import cv2
+
+        if image.ndim == 2:
+            image = cv2.cvtColor(image, cv2.COLOR_GRAY2BGRA)
+        elif image.shape[2] == 3:
+            image = cv2.cvtColor(image, cv2.COLOR_BGR2BGRA)
+        self._frame = np.ascontiguousarray(image)
+
+    def screen_size(self):
+        if self._frame is None:
+            return 0, 0
+        return self._frame.shape[1], self._frame.shape[0]
+
+    def grab(self, region=None):
+        if self._frame is None:
+            raise RuntimeError("No replay frame loaded")
+        if region is None:
+            return self._frame
+        x, y, w, h = (int(v) for v in region)
+        return self._frame[max(0, y): y + h, max(0, x): x + w]
+
+
+class SharedCapture:
+    """One grab per supervisor cycle, served to several window views as crops.
+
+    refresh() grabs the bounding box of every registered window once; views
+    then only slice that buffer, so N clients cost one capture instead of N.
+    """
+
+    def __init__(self, backend):
+        self.backend = backend
+        self.geometries = []  # (x, y, width, height) of every window
+        self._raw = None
+        self._origin = (0, 0)
+        self.timestamp = 0.0
+
+    def view(self, geometry):
+        """WindowView for a window at screen `geometry`"""
+        geometry = tuple(int(v) for v in geometry)
+        self.geometries.append(geometry)
+        return WindowView(self, geometry)
+
+    def refresh(self, timestamp):
+        """Grab every window at once (the buffer may be reused by the next refresh)"""
+        if not self.geometries:
+            return
+        x0 = min(g[0] for g in self.geometries)
+        y0 = min(g[1] for g in self.geometries)
+        x1 = max(g[0] + g[2] for g in self.geometries)
+        y1 = max(g[1] + g[3] for g in self.geometries)
+        self._raw = self.backend.grab((x0, y0, x1 - x0, y1 - y0))
+        self._origin = (x0, y0)
+        self.timestamp = timestamp
+
+    def crop(self, x, y, w, h):
+        """Screen region of the last refresh as a view"""
+        if self._raw is None:
+            raise RuntimeError("SharedCapture.refresh() has not been called yet")
+        x -= self._origin[0]
+        y -= self._origin[1]
+        return self._raw[max(0, y): y + h, max(0, x): x + w]
+
+
+class WindowView(CaptureBackend):
+    """Capture backend for one client window, in window coordinates, backed by a SharedCapture"""
+
+    name = "shared"
+
+    def __init__(self, shared, geometry):
+        self.shared = shared
+        self.geometry = geometry  # (x, y, width, height) on the screen
+
+    def screen_size(self):
+        return self.geometry[2], self.geometry[3]
+
+    def window_origin(self):
+        return self.geometry[0], self.geometry[1]
+
+    def grab(self, region=None):
+        wx, wy, ww, wh = self.geometry
+        if region is None:
+            return self.shared.crop(wx, wy, ww, wh)
+        x, y, w, h = (int(v) for v in region)
+        # Clip to the window so one client never sees its neighbour
+        x0, y0 = max(0, x), max(0, y)
+        x1, y1 = min(ww, x + w), min(wh, y + h)
+        return self.shared.crop(wx + x0, wy + y0, max(0, x1 - x0), max(0, y1 - y0))
+
+
+CAPTURE_BACKENDS = {
+    "x11": X11Capture,
+    "mss": MssCapture,
+    "pyautogui": PyAutoGuiCapture,
+}
+
+
+def create_capture_backend(preferred="auto", debug_mode=False):
+    """Create the fastest capture backend available on this system"""
+    if preferred != "auto":
+        order = [preferred]
+    elif platform.system() == "Linux":
+        order = ["x11", "mss", "pyautogui"]
+    else:
+        order = ["mss", "pyautogui"]
+
+    errors = []
+    for name in order:
+        try:
+            backend = CAPTURE_BACKENDS[name]()
+            if debug_mode:
+                extra = " (MIT-SHM)" if getattr(backend, "uses_shm", False) else ""
+                print(f"DEBUG: Using '{backend.name}' capture backend{extra}")
+            return backend
+        except Exception as e:
+            errors.append(f"{name}: {e}")
+            if debug_mode:
+                print(f"DEBUG: Capture backend '{name}' unavailable: {e}")
+
+    raise RuntimeError(f"No capture backend available ({'; '.join(errors)})")
+
+
+def create_window_capture(window, debug_mode=False):
+    """Capture backend for a single window, by ID/HWND or (part of) its title"""
+    system = platform.system()
+    if system == "Linux":
+        backend = X11WindowCapture(window)
+    elif system == "Windows":
+        backend = Win32WindowCapture(window)
+    else:
+        raise RuntimeError(f"Window capture is not supported on {system}, capture the screen instead")
+    if debug_mode:
+        width, height = backend.screen_size()
+        print(f"DEBUG: Capturing window '{window}' ({width}x{height}) with '{backend.name}'")
+    return backend
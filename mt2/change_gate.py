@@ -0,0 +1,57 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Frame-difference gating.
+A cheap mean absolute difference against the crop that was last evaluated
+tells whether an ROI changed; when it did not, the previous detector result
+is reused instead of matching again. Gates over bars compare per column, so a
+small drop at one end of the bar is not averaged away by the unchanged rest.
+"""
+
+import cv2
+
+
+class ChangeGate:
+    """Decide whether an ROI crop changed enough to be worth evaluating again"""
+
+    def __init__(self, threshold=2.0, sample_step=1, max_skip_time=1.0, per_column=False):
+        self.threshold = threshold  # Mean absolute pixel difference (0-255) that counts as a change
+        self.per_column = per_column  # Threshold the most changed column instead of the whole crop
+        self.sample_step = sample_step  # Compare every n-th pixel in both directions
+        self.max_skip_time = max_skip_time  # Evaluate at least this often even if nothing changed
+        self._reference = None
+        self._reference_time = 0.0
+        self.skipped = 0  # Number of evaluations saved
+
+    def _sample(self, crop):
+        if crop.ndim == 3 and crop.shape[2] == 4:
+            crop = crop[:, :, :3]  # Alpha never changes and would dilute the difference
+        if self.sample_step > 1:
+            crop = crop[:: self.sample_step, :: self.sample_step]
+        return crop
+
+    def unchanged(self, crop, timestamp):
+        """True when `crop` matches the last evaluated crop and it is not too old"""
+        if self._reference is None or timestamp - self._reference_time > self.max_skip_time:
+            return False
+        sample = self._sample(crop)
+        if sample.shape != self._reference.shape:
+            return False
+        difference = cv2.absdiff(sample, self._reference)
+        if self.per_column:
+            axes = (0, 2) if difference.ndim == 3 else 0
+            difference = difference.mean(axis=axes).max()
+        else:
+            difference = difference.mean()
+        if difference < self.threshold:
+            self.skipped += 1
+            return True
+        return False
+
+    def update(self, crop, timestamp):
+        """Remember `crop` as the last evaluated one"""
+        self._reference = self._sample(crop).copy()
+        self._reference_time = timestamp
+
+    def reset(self):
+        self._reference = None
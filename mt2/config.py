@@ -0,0 +1,169 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Declarative configuration.
+Detectors, templates, thresholds, ROIs and key bindings are read from a TOML
+file (config.toml next to this module by default). Values missing from the
+file fall back to DEFAULTS, and relative paths are resolved against the
+directory of the config file instead of the current working directory.
+"""
+
+import copy
+import os
+
+try:
+    import tomllib
+except ModuleNotFoundError:  # Python < 3.11
+    import tomli as tomllib
+
+DEFAULT_CONFIG_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), "config.toml")
+
+DEFAULTS = {
+    "templates": {
+        "path": "images",
+        "bundle": ".cache/templates",  # Memory-mappable template cache, "" disables it
+        "ui_scales": [0.75, 0.9, 1.0, 1.1, 1.25, 1.5],  # Resized variants tried during calibration
+    },
+    "capture": {
+        "window": "",  # Window ID or title to capture on its own, "" captures the screen
+    },
+    "roi": {
+        "padding": 20,
+        "lock_threshold": 0.6,
+        "keep_threshold": 0.45,
+        "max_misses": 3,
+    },
+    "keys": {
+        "health_potion": "1",
+        "mana_potion": "2",
+        "skills": ["3", "4", "5", "6"],
+    },
+    "calibration": {
+        "path": ".cache/calibration.json",  # Locked ROIs, UI scale and tuned thresholds, "" disables
+        "tune": False,  # Fit thresholds from this session's detector scores (also --calibrate)
+    },
+    "healing": {
+        "mode": "predictive",  # "predictive" (health trend) or "levels" (detectors.health.potion_levels)
+        "lead_time": 0.5,  # Seconds ahead to predict health: reaction, input and potion latency
+        "target": 0.7,  # Health a burst should restore
+        "heal_per_potion": 0.2,  # Health ratio one potion restores
+        "max_burst": 4,
+        "critical": 0.2,  # Predicted health that skips the wait for the previous burst
+        "window": 1.5,  # Seconds of readings the trend is fitted over
+        "min_samples": 3,
+    },
+    "respawn": {
+        "wait": 7.5,  # Seconds dead before looking for the respawn button
+        "poll_interval": 0.25,  # Seconds between respawn button checks once it is due
+        "heal_duration": 3.0,  # Seconds of forced healing after a respawn
+        "heal_potions": 2,  # Potions per post-respawn burst
+        "probe_interval": 5.0,  # Seconds between health checks while dead (revived by others), 0 disables
+    },
+    "control": {
+        "host": "127.0.0.1",  # Local only unless changed: commands press keys
+        "port": 0,  # Telemetry and start/stop/profile endpoint, 0 disables (also --control-port)
+    },
+    "startup": {
+        "fast": False,  # Monitor at launch from the calibration cache, no 'r' needed (also --fast-start)
+    },
+    "logging": {
+        "level": "info",  # debug, info, warning or error (--debug forces debug)
+        "status_interval": 1.0,  # Seconds between Health/Mana status lines
+    },
+    "instances": [],  # [{name, geometry = [x, y, w, h] or window, profile}] for supervisor.py
+    "skills": {
+        "enabled": False,  # Off unless asked for, it presses keys on its own
+        "global_cooldown": 1.0,
+        "default_cooldown": 5.0,
+        "rotation": [],  # [{key, cooldown, priority}]; empty = keys.skills in order
+    },
+    "detectors": {
+        "health": {
+            "levels": {
+                "20": "20_health_bar.png",
+                "40": "40_health_bar.png",
+                "50": "50_health_bar.png",
+                "full": "full_health_bar.png",
+            },
+            "min_score": 0.3,
+            "accept_score": 0.85,
+            "empty_ratio": 0.01,
+            "potion_threshold": 0.5,
+            "potion_levels": [[0.20, 4], [0.40, 2], [0.50, 1]],
+        },
+        "empty_health": {
+            "template": "empty_health_bar.png",
+            "threshold": 0.7,
+        },
+        "respawn_button": {
+            "template": "respawn_button.png",
+            "threshold": 0.8,
+            "region": [],  # Fixed (x, y, w, h) to poll; learnt from the first full-screen match when empty
+            "padding": 20,  # Extra pixels around the learnt button position
+        },
+        "mana": {
+            "enabled": False,  # Off unless asked for, it presses keys on its own
+            "region": [],  # Fixed (x, y, w, h); found by colour near the health bar when empty
+            "hsv_lower": [100, 100, 100],
+            "hsv_upper": [130, 255, 255],
+            "max_distance": 200,  # Auto-locate only this far (pixels) from the health bar
+            "relocate_interval": 5.0,  # Seconds between full-screen searches while the bar is lost
+            "potion_threshold": 0.5,
+            "potion_delay": 1.5,
+        },
+    },
+}
+
+# Detectors with dedicated handling in GameAutomation, every other entry is generic
+BUILTIN_DETECTORS = ("health", "empty_health", "respawn_button", "mana")
+
+
+def _merge(base, override):
+    """Recursively overlay `override` on a copy of `base`"""
+    merged = copy.deepcopy(base)
+    for key, value in override.items():
+        if isinstance(value, dict) and isinstance(merged.get(key), dict):
+            merged[key] = _merge(merged[key], value)
+        else:
+            merged[key] = value
+    return merged
+
+
+class Config(dict):
+    """Configuration mapping that knows where it was loaded from"""
+
+    def __init__(self, values, path=None):
+        super().__init__(values)
+        self.path = path
+        self.base_dir = os.path.dirname(os.path.abspath(path)) if path else os.path.dirname(DEFAULT_CONFIG_PATH)
+
+    def resolve(self, path):
+        """Absolute path for a config path; relative ones are taken from the config directory"""
+        if not path:
+            return path
+        path = os.path.expanduser(path)
+        return path if os.path.isabs(path) else os.path.join(self.base_dir, path)
+
+    def detector(self, name):
+        return self["detectors"].get(name, {})
+
+    def extra_detectors(self):
+        """{name: settings} of configured detectors without dedicated handling"""
+        return {
+            name: settings for name, settings in self["detectors"].items()
+            if name not in BUILTIN_DETECTORS
+        }
+
+
+def load_config(path=None):
+    """Read `path` (default config.toml) over DEFAULTS; a missing default file means defaults only"""
+    explicit = path is not None
+    path = path or DEFAULT_CONFIG_PATH
+    if not os.path.exists(path):
+        if explicit:
+            raise FileNotFoundError(f"Config file not found: {path}")
+        return Config(copy.deepcopy(DEFAULTS))
+
+    with open(path, "rb") as f:
+        values = tomllib.load(f)
+    return Config(_merge(DEFAULTS, values), path)
@@ -0,0 +1,163 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Local telemetry and control endpoint.
+A small HTTP server on its own threads answers with JSON snapshots of the
+running instances and hands commands to callbacks. Snapshots only read state
+the tick loop keeps anyway and commands are queued for whoever owns the
+instance, so polling it (or a slow client) does not add to detection latency.
+
+    GET  /status           every instance: health, mana, state, potions, stage timings
+    GET  /status/<name>    one instance
+    POST /start            {"instance": name}, optional
+    POST /stop             {"instance": name}, optional
+    POST /profile          {"profile": "client1.toml", "instance": name}
+
+Requests must name the bound address in Host (no DNS rebinding) and carry no
+Origin (browsers add one to cross-site requests); commands must be sent as
+Content-Type: application/json, which a web page cannot POST without a
+CORS preflight the server never answers.
+
+Usage: curl localhost:8765/status,
+       curl -H 'Content-Type: application/json' -d '{"profile": "pvp.toml"}' localhost:8765/profile
+"""
+
+import json
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import unquote, urlsplit
+
+from log import get_logger
+
+
+def _jsonable(value):
+    """json.dumps fallback for numpy scalars and other non-JSON values"""
+    if hasattr(value, "item"):
+        return value.item()
+    if isinstance(value, (set, frozenset)):
+        return sorted(value)
+    return str(value)
+
+
+class ControlServer:
+    """Serves `status()` snapshots over HTTP and runs POSTed commands as `commands[name](**body)`.
+
+    Commands must return quickly (queue work for the tick loop or another
+    thread); their return value is sent back, a ValueError or TypeError
+    becomes a 400 reply.
+    """
+
+    def __init__(self, status, commands, host="127.0.0.1", port=8765, log=None):
+        self.status = status  # () -> [snapshot dict of every instance]
+        self.commands = dict(commands)
+        self.host = host  # Local only by default: commands press keys
+        self.port = port
+        self.log = log or get_logger()
+        self._server = None
+        self._thread = None
+
+    @property
+    def address(self):
+        return f"http://{self.host}:{self.port}"
+
+    def start(self):
+        if self._server is not None:
+            return
+        self._server = ThreadingHTTPServer((self.host, self.port), self._handler())
+        self._server.daemon_threads = True
+        self.port = self._server.server_address[1]  # The one picked for port 0
+        self._thread = threading.Thread(target=self._server.serve_forever, name="control", daemon=True)
+        self._thread.start()
+        self.log.info("🛰️  Control endpoint at {} (GET /status, POST /start /stop /profile)", self.address)
+
+    def stop(self):
+        if self._server is None:
+            return
+        self._server.shutdown()
+        self._server.server_close()
+        self._thread.join(timeout=2.0)
+        self._server = None
+        self._thread = None
+
+    def _allowed_hosts(self):
+        hosts = {self.host, f"{self.host}:{self.port}"}
+        if self.host in ("127.0.0.1", "::1", "localhost"):
+            for local in ("127.0.0.1", "[::1]", "localhost"):
+                hosts.update((local, f"{local}:{self.port}"))
+        return hosts
+
+    def _status(self, name=None):
+        snapshots = self.status()
+        if name is None:
+            return snapshots
+        for snapshot in snapshots:
+            if snapshot.get("name") == name or (name == "default" and snapshot.get("name") is None):
+                return snapshot
+        return None
+
+    def _handler(self):
+        server = self
+
+        class Handler(BaseHTTPRequestHandler):
+            def _reply(self, code, payload):
+                body = json.dumps(payload, default=_jsonable).encode()
+                self.send_response(code)
+                self.send_header("Content-Type", "application/json")
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+            def _rejected(self):
+                """Reply 403 to requests a web page may have made on the user's behalf"""
+                host = self.headers.get("Host", "")
+                if host not in server._allowed_hosts():
+                    self._reply(403, {"error": f"unexpected Host '{host}'"})
+                    return True
+                if self.headers.get("Origin") is not None:
+                    self._reply(403, {"error": "cross-origin requests are not accepted"})
+                    return True
+                return False
+
+            def do_GET(self):
+                if self._rejected():
+                    return
+                path = urlsplit(self.path).path.rstrip("/")
+                if path == "/status":
+                    self._reply(200, server._status())
+                elif path.startswith("/status/"):
+                    snapshot = server._status(unquote(path[len("/status/"):]))
+                    if snapshot is None:
+                        self._reply(404, {"error": "unknown instance"})
+                    else:
+                        self._reply(200, snapshot)
+                else:
+                    self._reply(404, {"error": f"unknown path {path}"})
+
+            def do_POST(self):
+                if self._rejected():
+                    return
+                content_type = self.headers.get("Content-Type", "").split(";")[0].strip().lower()
+                if content_type != "application/json":
+                    self._reply(415, {"error": "commands must be sent as application/json"})
+                    return
+                name = urlsplit(self.path).path.strip("/")
+                command = server.commands.get(name)
+                if command is None:
+                    self._reply(404, {"error": f"unknown command '{name}'", "commands": sorted(server.commands)})
+                    return
+                try:
+                    length = int(self.headers.get("Content-Length") or 0)
+                    body = json.loads(self.rfile.read(length) or b"{}")
+                    if not isinstance(body, dict):
+                        raise ValueError("body must be a JSON object")
+                    result = command(**body)
+                except (TypeError, ValueError, OSError) as e:
+                    self._reply(400, {"error": str(e)})
+                    return
+                server.log.info("Control: {} {}", name, body or "")
+                self._reply(202, {"ok": True, "result": result})
+
+            def log_message(self, format, *args):
+                server.log.debug("Control {}: {}", self.address_string(), format % args)
+
+        return Handler
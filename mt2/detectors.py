@@ -0,0 +1,58 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Generic detectors declared in the config file.
+Each one is a template looked for in an optional screen region every
+`interval` seconds, pressing a key or clicking the match when it is found.
+"""
+
+
+class TemplateDetector:
+    """A configured template with the action to take when it shows up"""
+
+    def __init__(self, name, template_name, threshold=0.8, region=None, interval=1.0, key=None, click=False):
+        self.name = name
+        self.template_name = template_name  # Name in the TemplateStore, loaded on the first check
+        self.threshold = threshold
+        self.region = tuple(int(v) for v in region) if region else None  # (x, y, w, h), None = full screen
+        self.interval = interval
+        self.key = key
+        self.click = click
+        self.next_check = 0.0  # time.monotonic() of the next check
+
+    @classmethod
+    def from_config(cls, name, settings, template_store):
+        """Build from a [detectors.<name>] table, registering its template for lazy loading"""
+        kind = settings.get("type", "template")
+        if kind != "template":
+            raise ValueError(f"Detector '{name}': unknown type '{kind}'")
+        if "template" not in settings:
+            raise ValueError(f"Detector '{name}': missing 'template'")
+        template_name = f"detector_{name}"
+        template_store.register(template_name, settings["template"])
+        return cls(
+            name,
+            template_name,
+            threshold=settings.get("threshold", 0.8),
+            region=settings.get("region"),
+            interval=settings.get("interval", 1.0),
+            key=settings.get("key"),
+            click=settings.get("click", False),
+        )
+
+    def due(self, now):
+        return now >= self.next_check
+
+    def detect(self, frame, matcher, template_store, ui_scale=None):
+        """(found, screen position of the match centre) in `frame`"""
+        template = template_store.get(self.template_name, ui_scale)
+        if template is None:
+            return False, None
+        if matcher.can_downscale(template) and frame.gray.size > 16 * template.gray.size:
+            score, loc = matcher.match(frame.gray, template, frame.gray_scaled(matcher.scale))
+        else:
+            score, loc = matcher.time_full(frame.gray, template)
+        if loc is None or score < self.threshold:
+            return False, None
+        w, h = template.size
+        return True, frame.to_screen(loc[0] + w // 2, loc[1] + h // 2)
@@ -0,0 +1,111 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Per-tick frame shared by every detector.
+A frame is captured once per loop iteration and caches its colour conversions,
+so all detectors look at the same instant and pay for each conversion only once.
+"""
+
+import time
+
+import cv2
+
+from matching import downscale
+
+
+class Frame:
+    """A captured BGRA screen image with lazily cached BGR/grayscale conversions.
+
+    `origin` is the screen position of pixel (0, 0), so detectors working on a
+    cropped frame can still report screen coordinates. The raw buffer may be
+    owned by the capture backend and overwritten by its next grab; call
+    `detach()` before handing a frame to another thread.
+    """
+
+    def __init__(self, raw, origin=(0, 0), timestamp=None, metrics=None):
+        self.raw = raw
+        self.origin = origin
+        self.timestamp = time.monotonic() if timestamp is None else timestamp
+        self.metrics = metrics  # Optional StageMetrics for the capture/convert timings
+        self._bgr = None
+        self._gray = None
+        self._gray_scaled = {}
+
+    @classmethod
+    def capture(cls, backend, region=None, metrics=None):
+        """Grab a new frame (optionally only an (x, y, width, height) region)"""
+        timestamp = time.monotonic()
+        raw = backend.grab(region)
+        if metrics is not None:
+            metrics.record("capture", time.monotonic() - timestamp)
+        origin = (int(region[0]), int(region[1])) if region is not None else (0, 0)
+        return cls(raw, origin=origin, timestamp=timestamp, metrics=metrics)
+
+    @property
+    def shape(self):
+        return self.raw.shape
+
+    @property
+    def width(self):
+        return self.raw.shape[1]
+
+    @property
+    def height(self):
+        return self.raw.shape[0]
+
+    @property
+    def bgr(self):
+        """BGR image, converted on first access"""
+        if self._bgr is None:
+            start = time.perf_counter()
+            self._bgr = cv2.cvtColor(self.raw, cv2.COLOR_BGRA2BGR)
+            if self.metrics is not None:
+                self.metrics.record("convert_bgr", time.perf_counter() - start)
+        return self._bgr
+
+    @property
+    def gray(self):
+        """Grayscale image, converted on first access"""
+        if self._gray is None:
+            start = time.perf_counter()
+            self._gray = cv2.cvtColor(self.raw, cv2.COLOR_BGRA2GRAY)
+            if self.metrics is not None:
+                self.metrics.record("convert_gray", time.perf_counter() - start)
+        return self._gray
+
+    def gray_scaled(self, scale):
+        """Downscaled grayscale image for coarse searches, cached per scale"""
+        cached = self._gray_scaled.get(scale)
+        if cached is None:
+            cached = downscale(self.gray, scale)
+            self._gray_scaled[scale] = cached
+        return cached
+
+    def to_screen(self, x, y):
+        """Convert frame pixel coordinates to screen coordinates"""
+        return x + self.origin[0], y + self.origin[1]
+
+    def crop(self, region):
+        """Return a view of an (x, y, width, height) screen region as a new Frame"""
+        x, y, w, h = region
+        x0 = max(0, int(x) - self.origin[0])
+        y0 = max(0, int(y) - self.origin[1])
+        x1 = min(self.width, x0 + int(w))
+        y1 = min(self.height, y0 + int(h))
+        cropped = Frame(
+            self.raw[y0:y1, x0:x1],
+            origin=(self.origin[0] + x0, self.origin[1] + y0),
+            timestamp=self.timestamp,
+            metrics=self.metrics,
+        )
+        # Share conversions that were already computed on the parent
+        if self._bgr is not None:
+            cropped._bgr = self._bgr[y0:y1, x0:x1]
+        if self._gray is not None:
+            cropped._gray = self._gray[y0:y1, x0:x1]
+        return cropped
+
+    def detach(self):
+        """Copy the raw buffer so the frame survives the backend's next grab"""
+        self.raw = self.raw.copy()
+        return self
@@ -0,0 +1,104 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Predictive healing.
+A least-squares fit over the last readings gives the rate health is lost at,
+so potions can go out before the threshold is crossed, sized by the damage
+expected while they take effect instead of a fixed table per health level.
+"""
+
+import math
+from collections import deque
+
+
+class HealthRateEstimator:
+    """Sliding-window linear fit of timestamped health ratios"""
+
+    def __init__(self, window=1.5, min_samples=3, min_span=0.2, heal_jump=0.05):
+        self.window = window  # Seconds of readings kept
+        self.min_samples = min_samples
+        self.min_span = min_span  # Readings must cover at least this many seconds
+        self.heal_jump = heal_jump  # A rise this large is a heal: the damage trend restarts from it
+        self._readings = deque()  # (timestamp, ratio)
+
+    def __len__(self):
+        return len(self._readings)
+
+    def add(self, timestamp, ratio):
+        if self._readings and ratio - self._readings[-1][1] > self.heal_jump:
+            self._readings.clear()
+        self._readings.append((timestamp, ratio))
+        while self._readings and timestamp - self._readings[0][0] > self.window:
+            self._readings.popleft()
+
+    def clear(self):
+        self._readings.clear()
+
+    def rate(self):
+        """Health ratio change per second (negative while losing health), None without enough data"""
+        n = len(self._readings)
+        if n < self.min_samples or self._readings[-1][0] - self._readings[0][0] < self.min_span:
+            return None
+        t0 = self._readings[0][0]
+        mean_t = sum(t - t0 for t, _ in self._readings) / n
+        mean_h = sum(h for _, h in self._readings) / n
+        covariance = sum((t - t0 - mean_t) * (h - mean_h) for t, h in self._readings)
+        variance = sum((t - t0 - mean_t) ** 2 for t, _ in self._readings)
+        return covariance / variance if variance > 0 else None
+
+    def predict(self, health, seconds):
+        """Health expected `seconds` after a reading of `health` at the current rate"""
+        rate = self.rate()
+        return health if rate is None else health + rate * seconds
+
+    def time_to(self, health, threshold):
+        """Seconds until `health` falls to `threshold`; 0 when already there, None when not falling"""
+        if health <= threshold:
+            return 0.0
+        rate = self.rate()
+        if rate is None or rate >= 0:
+            return None
+        return (threshold - health) / rate
+
+
+class PredictiveHealer:
+    """Decide when and how many potions to use from the predicted health"""
+
+    def __init__(self, estimator, threshold=0.5, lead_time=0.5, target=0.7, heal_per_potion=0.2,
+                 max_burst=4, horizon=1.5, critical=0.2):
+        self.estimator = estimator
+        self.threshold = threshold  # Heal before health is expected to drop below this
+        self.lead_time = lead_time  # Seconds ahead to predict: reaction, input and potion latency
+        self.target = target  # Health a burst should bring us back to
+        self.heal_per_potion = heal_per_potion  # Health ratio one potion restores
+        self.max_burst = max_burst
+        self.horizon = horizon  # Seconds until the next burst can follow, damage taken meanwhile counts
+        self.critical = critical  # Predicted health that skips the wait for the previous burst
+
+    def plan(self, health, pending=0):
+        """Potions to use now for a reading of `health` with `pending` potions not yet shown (0 = none needed)"""
+        predicted = self.estimator.predict(health, self.lead_time)
+        if predicted > self.threshold:
+            return 0
+        rate = self.estimator.rate() or 0.0
+        expected_damage = max(0.0, -rate) * self.horizon
+        deficit = self.target - predicted + expected_damage - pending * self.heal_per_potion
+        if deficit <= 0:
+            return 0
+        return max(1, min(self.max_burst, math.ceil(deficit / self.heal_per_potion)))
+
+    def emergency(self, health, pending=0):
+        """True when health is expected to be critical even after the `pending` potions not yet shown land"""
+        predicted = self.estimator.predict(health, self.lead_time)
+        return predicted + pending * self.heal_per_potion <= self.critical
+
+    def next_check(self, health):
+        """Seconds until the next reading should be taken to heal in time.
+
+        None when not falling, or already at the threshold: then the regular
+        combat polling rate applies.
+        """
+        remaining = self.estimator.time_to(health, self.threshold)
+        if remaining is None or remaining <= 0:
+            return None
+        return max(0.0, remaining - self.lead_time)
@@ -0,0 +1,195 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Asynchronous input dispatch.
+Key presses and clicks are queued with a due time and sent by one worker
+thread that owns a long-lived pynput controller, so detection never blocks
+on key timing. Queued actions can be cancelled by tag (e.g. on death).
+pynput types into the focused window; a `keys` sender (see key_sender() of
+the window captures) aims them at one window instead, and `keys_blocked`
+refuses key presses outright where neither is safe.
+"""
+
+import heapq
+import itertools
+import threading
+import time
+
+from log import get_logger
+
+
+class InputAction:
+    """A timed key press or click waiting in the dispatch queue"""
+
+    __slots__ = ("kind", "args", "due", "priority", "tag", "cancelled")
+
+    def __init__(self, kind, args, due, priority, tag):
+        self.kind = kind
+        self.args = args
+        self.due = due
+        self.priority = priority
+        self.tag = tag
+        self.cancelled = False
+
+
+class InputDispatcher:
+    """Single worker thread sending queued inputs in due-time, then priority order"""
+
+    # Lower runs first when several actions are due at the same time
+    PRIORITY_HEAL = 0
+    PRIORITY_RESPAWN = 5
+    PRIORITY_MANA = 10
+    PRIORITY_SKILL = 20
+    PRIORITY_DEFAULT = 50
+
+    def __init__(self, debug_mode=False, metrics=None, log=None, keys=None, keys_blocked=None):
+        self.debug_mode = debug_mode
+        self.log = log or get_logger()
+        self.metrics = metrics  # Optional StageMetrics, records "input_key"/"input_click"
+        self._timed = []  # heap of (due, seq, action)
+        self._ready = []  # heap of (priority, seq, action) for actions already due
+        self._seq = itertools.count()
+        self._condition = threading.Condition()
+        self._thread = None
+        self._running = False
+        self._keys = keys  # Object with tap(key, duration); None = pynput into the focused window
+        self.keys_blocked = keys_blocked  # Reason key presses are refused, None = allowed
+        self._keyboard = None  # pynput and pyautogui are imported on the worker when first needed
+        self._pointer = None
+
+    def start(self):
+        with self._condition:
+            if self._running:
+                return
+            self._running = True
+            self._thread = threading.Thread(target=self._worker, name="input-dispatcher", daemon=True)
+            self._thread.start()
+
+    def stop(self, cancel_pending=True):
+        if cancel_pending:
+            self.cancel()
+        with self._condition:
+            self._running = False
+            self._condition.notify_all()
+        if self._thread is not None:
+            self._thread.join(timeout=2.0)
+            self._thread = None
+
+    def _submit(self, kind, args, delay, priority, tag):
+        action = InputAction(kind, args, time.monotonic() + max(0.0, delay), priority, tag)
+        with self._condition:
+            heapq.heappush(self._timed, (action.due, next(self._seq), action))
+            self._condition.notify()
+        if not self._running:
+            self.start()
+        return action
+
+    def press(self, key, duration=0.1, delay=0.0, priority=PRIORITY_DEFAULT, tag=None):
+        """Queue a key press held for `duration` seconds, starting after `delay` (None while keys are blocked)"""
+        if self.keys_blocked:
+            self.log.warning("Key '{}' not sent: {}", key, self.keys_blocked, every=30.0, key="keys_blocked")
+            return None
+        return self._submit("key", (key, duration), delay, priority, tag)
+
+    def burst(self, key, count, spacing, duration=0.1, delay=0.0, priority=PRIORITY_DEFAULT, tag=None):
+        """Queue `count` presses of `key`, `spacing` seconds apart"""
+        return [
+            self.press(key, duration, delay + i * spacing, priority, tag)
+            for i in range(count)
+        ]
+
+    def click(self, x, y, delay=0.0, priority=PRIORITY_DEFAULT, tag=None):
+        """Queue a left click at screen position (x, y)"""
+        return self._submit("click", (x, y), delay, priority, tag)
+
+    def warm_up(self, delay=0.0):
+        """Import the input backends on the worker now instead of on the first key press or click"""
+        return self._submit("warm", (), delay, self.PRIORITY_DEFAULT, "warm")
+
+    def cancel(self, tag=None):
+        """Cancel queued actions with `tag` (all actions when tag is None); returns the count"""
+        cancelled = 0
+        with self._condition:
+            for heap in (self._timed, self._ready):
+                for _, _, action in heap:
+                    if not action.cancelled and (tag is None or action.tag == tag):
+                        action.cancelled = True
+                        cancelled += 1
+            self._condition.notify()
+        if cancelled and self.debug_mode:
+            self.log.debug("Cancelled {} queued input(s) (tag: {})", cancelled, tag)
+        return cancelled
+
+    def pending(self, tag=None):
+        """Number of queued, not yet sent actions (optionally only with `tag`)"""
+        with self._condition:
+            return sum(
+                1
+                for heap in (self._timed, self._ready)
+                for _, _, action in heap
+                if not action.cancelled and (tag is None or action.tag == tag)
+            )
+
+    def _next_action(self):
+        """Block until an action is due; returns None when stopping"""
+        with self._condition:
+            while self._running:
+                now = time.monotonic()
+                while self._timed and self._timed[0][0] <= now:
+                    _, seq, action = heapq.heappop(self._timed)
+                    heapq.heappush(self._ready, (action.priority, seq, action))
+                while self._ready:
+                    _, _, action = heapq.heappop(self._ready)
+                    if not action.cancelled:
+                        return action
+
+                timeout = self._timed[0][0] - now if self._timed else None
+                self._condition.wait(timeout)
+        return None
+
+    def _keyboard_controller(self):
+        if self._keyboard is None:
+            from pynput.keyboard import Controller
+
+            self._keyboard = Controller()
+        return self._keyboard
+
+    def _pointer_module(self):
+        if self._pointer is None:
+            import pyautogui
+
+            # Safety settings: pyautogui keeps its FAILSAFE corner check for clicks
+            pyautogui.FAILSAFE = True
+            pyautogui.PAUSE = 0.1
+            self._pointer = pyautogui
+        return self._pointer
+
+    def _worker(self):
+        while True:
+            action = self._next_action()
+            if action is None:
+                break
+            start = time.perf_counter()
+            try:
+                if action.kind == "key":
+                    key, duration = action.args
+                    if self._keys is not None:
+                        self._keys.tap(key, duration)
+                    else:
+                        keyboard = self._keyboard_controller()
+                        keyboard.press(key)
+                        time.sleep(duration)
+                        keyboard.release(key)
+                    if self.debug_mode:
+                        self.log.debug("Key '{}' pressed successfully", key)
+                elif action.kind == "click":
+                    self._pointer_module().click(action.args[0], action.args[1])
+                elif action.kind == "warm":
+                    if self._keys is None:
+                        self._keyboard_controller()
+                    self._pointer_module()
+                    continue
+            except Exception as e:
+                self.log.error("Failed to send input {} {}: {}", action.kind, action.args, e)
+            if self.metrics is not None:
+                self.metrics.record(f"input_{action.kind}", time.perf_counter() - start)
@@ -0,0 +1,107 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Death and respawn state machine.
+Every state has a deadline on time.monotonic() for its next timed event, so
+the loop sleeps until something can actually happen instead of polling, and
+each state only runs the detectors it needs:
+
+    ALIVE      health (and mana, skills, extra detectors) every tick
+    DEAD       nothing until the respawn wait is over, an occasional health probe
+    RESPAWN    the respawn button only, in its ROI, every poll_interval
+    REVIVING   post-respawn heals until heal_duration is over, then ALIVE
+"""
+
+import time
+
+
+class LifeStateMachine:
+    """Timed transitions between ALIVE, DEAD, RESPAWN and REVIVING"""
+
+    ALIVE = "alive"
+    DEAD = "dead"
+    RESPAWN = "respawn"
+    REVIVING = "reviving"
+
+    def __init__(self, respawn_wait=7.5, poll_interval=0.25, heal_duration=3.0, probe_interval=5.0,
+                 clock=time.monotonic):
+        self.respawn_wait = respawn_wait  # Seconds dead before the respawn button is looked for
+        self.poll_interval = poll_interval  # Seconds between respawn button checks
+        self.heal_duration = heal_duration  # Seconds of forced healing after a respawn
+        self.probe_interval = probe_interval  # Seconds between health checks while dead, 0 disables
+        self.clock = clock
+
+        self.state = self.ALIVE
+        self.entered = clock()
+        self.deadline = None  # Next timed event of the current state
+        self.next_probe = None
+        self.deaths = 0
+        self.respawns = 0
+
+    def _enter(self, state, now, deadline=None):
+        self.state = state
+        self.entered = now
+        self.deadline = deadline
+
+    @property
+    def alive(self):
+        return self.state == self.ALIVE
+
+    def elapsed(self, now=None):
+        """Seconds spent in the current state"""
+        return (self.clock() if now is None else now) - self.entered
+
+    def due(self, now):
+        """True when the current state's timed event has come"""
+        return self.deadline is not None and now >= self.deadline
+
+    def died(self, now, button_visible=False):
+        """ALIVE -> DEAD, or straight to RESPAWN when the button is already up"""
+        self.deaths += 1
+        self.next_probe = now + self.probe_interval if self.probe_interval > 0 else None
+        if button_visible:
+            self._enter(self.RESPAWN, now, now)
+        else:
+            self._enter(self.DEAD, now, now + self.respawn_wait)
+
+    def advance(self, now):
+        """Apply the purely timed transitions; returns the (possibly new) state"""
+        if self.state == self.DEAD and self.due(now):
+            self._enter(self.RESPAWN, now, now)
+        elif self.state == self.REVIVING and self.due(now):
+            self._enter(self.ALIVE, now)
+        return self.state
+
+    def button_missing(self, now):
+        """RESPAWN poll found nothing: check again after poll_interval"""
+        self.deadline = now + self.poll_interval
+
+    def respawned(self, now):
+        """RESPAWN -> REVIVING after the button was clicked"""
+        self.respawns += 1
+        self.next_probe = None
+        self._enter(self.REVIVING, now, now + self.heal_duration)
+
+    def probe_due(self, now):
+        """True when a dead state should check whether health came back on its own"""
+        return self.next_probe is not None and now >= self.next_probe and self.state in (self.DEAD, self.RESPAWN)
+
+    def probed(self, now, revived):
+        """Result of a health probe: ALIVE when revived (e.g. by another player), else probe later"""
+        if revived:
+            self.next_probe = None
+            self._enter(self.ALIVE, now)
+        else:
+            self.next_probe = now + self.probe_interval
+
+    def reset(self, now=None):
+        """Back to ALIVE, e.g. at the start of a session"""
+        self.next_probe = None
+        self._enter(self.ALIVE, self.clock() if now is None else now)
+
+    def time_to_event(self, now):
+        """Seconds until the next deadline or probe, None when nothing is scheduled"""
+        events = [t for t in (self.deadline, self.next_probe) if t is not None]
+        if not events:
+            return None
+        return max(0.0, min(events) - now)
@@ -0,0 +1,173 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Asynchronous leveled logging.
+Log calls only check the level and rate limit and queue the message with its
+arguments; formatting ("{}"-style, like str.format) and the write happen on a
+single writer thread, which also runs deferred I/O such as metrics exports, so
+the tick loop never waits on stdout or a file.
+"""
+
+import atexit
+import functools
+import sys
+import threading
+import time
+import traceback
+from collections import deque
+
+DEBUG = 10
+INFO = 20
+WARNING = 30
+ERROR = 40
+
+LEVELS = {"debug": DEBUG, "info": INFO, "warning": WARNING, "error": ERROR}
+_TAGS = {DEBUG: "DEBUG: ", INFO: "", WARNING: "WARNING: ", ERROR: "ERROR: "}
+
+
+class LogWriter:
+    """Writer thread draining queued log records and deferred calls in order"""
+
+    def __init__(self, stream=None, max_pending=4096):
+        self.stream = stream  # None = sys.stdout at write time, so redirection is followed
+        self.max_pending = max_pending  # Oldest records are dropped beyond this
+        self.dropped = 0
+        self._pending = deque()
+        self._condition = threading.Condition()
+        self._busy = False
+        self._thread = None
+        self._lock = threading.Lock()
+
+    def submit(self, item):
+        """Queue a (prefix, level, message, args, suppressed) record or a callable"""
+        with self._condition:
+            if len(self._pending) >= self.max_pending:
+                self._pending.popleft()
+                self.dropped += 1
+            self._pending.append(item)
+            self._condition.notify()
+        if self._thread is None:
+            self._start()
+
+    def _start(self):
+        with self._lock:
+            if self._thread is None:
+                self._thread = threading.Thread(target=self._run, name="log", daemon=True)
+                self._thread.start()
+
+    def _run(self):
+        while True:
+            with self._condition:
+                while not self._pending:
+                    self._busy = False
+                    self._condition.notify_all()
+                    self._condition.wait()
+                self._busy = True
+                batch = list(self._pending)
+                self._pending.clear()
+
+            stream = self.stream or sys.stdout
+            for item in batch:
+                try:
+                    if callable(item):
+                        item()
+                    else:
+                        stream.write(self._format(*item))
+                except Exception:
+                    traceback.print_exc(file=sys.stderr)
+            try:
+                stream.flush()
+            except (OSError, ValueError):
+                pass
+
+    @staticmethod
+    def _format(prefix, level, message, args, suppressed):
+        if args:
+            try:
+                message = message.format(*args)
+            except (IndexError, KeyError, ValueError) as e:
+                message = f"{message} {args!r} (format error: {e})"
+        if suppressed:
+            message = f"{message} (+{suppressed} suppressed)"
+        return f"{prefix}{_TAGS.get(level, '')}{message}\n"
+
+    def flush(self, timeout=2.0):
+        """Wait until everything queued so far has been written"""
+        if self._thread is None:
+            return True
+        deadline = time.monotonic() + timeout
+        with self._condition:
+            while self._pending or self._busy:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    return False
+                self._condition.wait(remaining)
+        return True
+
+
+_default_writer = None
+_default_lock = threading.Lock()
+
+
+def default_writer():
+    """Process-wide writer shared by every Logger (flushed at exit)"""
+    global _default_writer
+    with _default_lock:
+        if _default_writer is None:
+            _default_writer = LogWriter()
+            atexit.register(_default_writer.flush)
+        return _default_writer
+
+
+class Logger:
+    """Leveled, rate-limited front end queuing to a LogWriter"""
+
+    def __init__(self, name=None, level=INFO, writer=None):
+        self.prefix = f"[{name}] " if name else ""
+        self.level = LEVELS[level] if isinstance(level, str) else level
+        self.writer = writer if writer is not None else default_writer()
+        self._last = {}  # rate limit key -> [time.monotonic() of the last emit, suppressed since]
+
+    def enabled(self, level):
+        return level >= self.level
+
+    def log(self, level, message, *args, every=None, key=None):
+        """Queue `message.format(*args)`; with `every`, at most once per that many seconds per key"""
+        if level < self.level:
+            return False
+        suppressed = 0
+        if every is not None:
+            key = message if key is None else key
+            now = time.monotonic()
+            last = self._last.get(key)
+            if last is not None and now - last[0] < every:
+                last[1] += 1
+                return False
+            if last is not None:
+                suppressed = last[1]
+            self._last[key] = [now, 0]
+        self.writer.submit((self.prefix, level, message, args, suppressed))
+        return True
+
+    def debug(self, message, *args, **kwargs):
+        return self.log(DEBUG, message, *args, **kwargs)
+
+    def info(self, message, *args, **kwargs):
+        return self.log(INFO, message, *args, **kwargs)
+
+    def warning(self, message, *args, **kwargs):
+        return self.log(WARNING, message, *args, **kwargs)
+
+    def error(self, message, *args, **kwargs):
+        return self.log(ERROR, message, *args, **kwargs)
+
+    def defer(self, function, *args, **kwargs):
+        """Run blocking I/O (exports, file writes) on the writer thread, in order with the log lines"""
+        self.writer.submit(functools.partial(function, *args, **kwargs))
+
+    def flush(self, timeout=2.0):
+        return self.writer.flush(timeout)
+
+
+def get_logger(name=None, level=INFO):
+    return Logger(name=name, level=level)
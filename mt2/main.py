@@ -5,222 +5,570 @@ This is a script to automate healing, mana and skill usage.
 This is created only for educational purposes.
 """
 
+import os
 import time
+
+LAUNCH_TIME = time.monotonic()  # Startup is timed from here to the first health reading
+
 import cv2
-import numpy as np
-import pyautogui
-from pynput import keyboard as pynput_keyboard
-from PIL import Image
-import os
-import platform
 import argparse
+import threading
+
+from capture import create_capture_backend, create_window_capture
+from frame import Frame
+from roi import RoiLock, union_region
+from templates import TemplateStore
+from fill_estimator import ColorFillEstimator, FillRatioEstimator
+from matching import (
+    DEBUG_CONFIDENCE_LEVELS, GPU_BACKENDS, MATCHER_BACKENDS, MatchPool, PyramidMatcher, TemplateCascade, confidence_levels, downscale
+)
+from scheduler import AdaptivePollingScheduler
+from input_dispatcher import InputDispatcher
+from pipeline import PipelinedRuntime
+from metrics import StageMetrics
+from recorder import FrameRecorder
+from change_gate import ChangeGate
+from calibration import CalibrationCache, ScoreRecorder, fit_floor, fit_separation
+from config import Config, load_config
+from detectors import TemplateDetector
+from health_trend import HealthRateEstimator, PredictiveHealer
+from life_state import LifeStateMachine
+from skills import Skill, SkillRotation
+from log import DEBUG, Logger
+from control import ControlServer
+
+
+def start_hotkey_listener(on_press):
+    """Start a background pynput keyboard listener (pynput is slow to import, so only when needed)"""
+    from pynput import keyboard as pynput_keyboard
+
+    listener = pynput_keyboard.Listener(on_press=on_press)
+    listener.start()
+    return listener
 
 
 #TODO: make modules better
 class GameAutomation:
-    def __init__(self, debug_mode=False):
-        # Debug mode control - set to False for reduced CPU usage
+    def __init__(self, debug_mode=False, latency_budget=0.2, cpu_budget=0.25, pipelined=True,
+                 metrics_interval=30.0, metrics_export=None, capture_backend=None, record_seconds=10.0,
+                 match_workers=None, config=None, skills=None, matcher_backend="auto", gpu="off",
+                 template_store=None, match_pool=None, screen_origin=(0, 0), name=None, window=None,
+                 calibrate=None, keys=None, keys_blocked=None):
+        # Debug mode control - verbose diagnostics, detection timing stays the same
         self.debug_mode = debug_mode
+        self.name = name  # Instance name when one process supervises several clients
+
+        # Screen position of this instance's (0, 0); capture and detection work in window
+        # coordinates, clicks are translated back with it
+        self.screen_origin = tuple(screen_origin)
+
+        # Detectors, templates, thresholds, ROI and keys come from config.toml (or `config`)
+        self.config = config if isinstance(config, Config) else load_config(config)
+        health_config = self.config.detector("health")
+
+        # Log lines are formatted and written off the tick thread; per-tick status lines are rate limited
+        logging_config = self.config["logging"]
+        self.log = Logger(name=name, level=DEBUG if debug_mode else logging_config["level"])
+        self.status_interval = logging_config["status_interval"]
+
+        # Stage timings are always recorded (cheap), summarised every metrics_interval seconds
+        # (the summary and export are written by the logger thread)
+        self.metrics = StageMetrics(summary_interval=metrics_interval, export_path=metrics_export, log=self.log)
+
+        # Last few seconds of health ROI crops, dumped on death or with the 'd' hotkey
+        self.recorder = FrameRecorder(seconds=record_seconds, log=self.log) if record_seconds > 0 else None
+        self.last_health_percent = None
+        self.first_reading = threading.Event()  # Set by the first tick that reads health
+
+        # Capture on its own thread while detection runs (set up by run_automation)
+        self.pipelined = pipelined
+        self.pipeline = None
+        self.automation_running = False
+
+        # Polling rate follows health trend and state within these budgets
+        self.scheduler = AdaptivePollingScheduler(latency_budget=latency_budget, cpu_budget=cpu_budget)
         
         # Configuration for health bar detection using pre-captured images
-        self.health_images_path = "images"
+        self.health_images_path = self.config.resolve(self.config["templates"]["path"])
+        if template_store is None:
+            template_store = TemplateStore(
+                self.health_images_path,
+                debug_mode=self.debug_mode,
+                bundle_path=self.config.resolve(self.config["templates"]["bundle"]) or None,
+                ui_scales=self.config["templates"]["ui_scales"],
+            )
+        self.template_store = template_store  # May be shared with other instances
+        self.ui_scale = 1.0  # UI scale learnt by calibrate_health_roi
         self.health_templates = {}
         self.load_health_templates()
         
-        # Load respawn and empty health templates
+        # Load respawn and empty health templates (the respawn button lazily, on first death)
         self.empty_health_template = None
-        self.respawn_button_template = None
+        self.empty_health_threshold = self.config.detector("empty_health")["threshold"]
+        self.respawn_threshold = self.config.detector("respawn_button")["threshold"]
         self.load_respawn_templates()
 
-        # Configuration for mana (WIP - commented out for now)
-        # self.mana_bar_region = None    # (x, y, width, height) - to be set
+        # Extra template detectors declared in the config
+        self.extra_detectors = []
+        for name, settings in self.config.extra_detectors().items():
+            try:
+                self.extra_detectors.append(TemplateDetector.from_config(name, settings, self.template_store))
+            except ValueError as e:
+                self.log.error("{}", e)
+        self.template_store.save_bundle()
+
+        # Coarse-to-fine matcher for full-screen searches (respawn button, bar acquisition),
+        # which spread over match_workers threads (None = one per core up to 8, 1 = serial)
+        self.match_pool = match_pool if match_pool is not None else MatchPool(match_workers)
+        # Small ROI matches use the native kernel when it is built (matcher_backend "auto"/"native"),
+        # large ones can move to the GPU
+        self.pyramid_matcher = PyramidMatcher(
+            scale=0.5, candidates=3, metrics=self.metrics, pool=self.match_pool, backend=matcher_backend, gpu=gpu
+        )
+        if self.debug_mode:
+            self.pyramid_matcher.full_results = {}  # Kept for the per-template confidence report
+        if self.pyramid_matcher.gpu is not None:
+            self.log.info("Full-screen searches run on the GPU ({})", self.pyramid_matcher.gpu.kind)
+        # Health templates are tried most-likely first and stop at the first confident match
+        self.health_cascade = TemplateCascade(
+            self.pyramid_matcher, accept=health_config["accept_score"], reject=health_config["min_score"]
+        )
+
+        # Health bar position, found once by a full-screen search then tracked in a small ROI
+        self.health_roi = RoiLock(**self.config["roi"])
+        self.last_health_match = (None, 0.0, None)  # (template, score, location in searched image)
+
+        # Continuous health reading from the locked bar, templates are only used to find it
+        self.health_estimator = self._create_health_estimator()
+        self._last_health_estimate = (None, None)  # (frame, ratio) so a tick estimates once
+        self.empty_health_ratio = health_config["empty_ratio"]  # Fill ratio at or below which the bar counts as empty
+
+        # Unchanged ROIs reuse the previous result instead of being matched again
+        self.health_gate = ChangeGate(threshold=2.0, max_skip_time=1.0, per_column=True)
+        self._gated_health = None  # (empty, health ratio) of the last evaluated bar crop
+        self.respawn_gate = ChangeGate(threshold=2.0, max_skip_time=2.0)
+        self._gated_respawn = (False, None)  # Last respawn button result of the gated frame
+
+        # Respawn button position, learnt from its first full-screen match (or fixed in the config);
+        # later polls only capture and match around it
+        respawn_config = self.config.detector("respawn_button")
+        self.respawn_region = tuple(int(v) for v in respawn_config["region"]) or None
+        self.respawn_roi = RoiLock(padding=respawn_config["padding"], lock_threshold=self.respawn_threshold,
+                                   keep_threshold=self.respawn_threshold)
+
+        # Mana is read by colour from its own locked ROI inside the same tick frame
+        mana_config = self.config.detector("mana")
+        self.mana_estimator = None
+        if mana_config["enabled"]:
+            self.mana_estimator = ColorFillEstimator(mana_config["hsv_lower"], mana_config["hsv_upper"])
+        self.mana_region = tuple(mana_config["region"]) or None  # Fixed region from the config
+        # Exact bar bounds; the estimate confidence keeps the lock alive
+        self.mana_roi = RoiLock(padding=0, lock_threshold=0.0, keep_threshold=0.8)
+        self.mana_max_distance = mana_config["max_distance"]
+        self.mana_relocate_interval = mana_config["relocate_interval"]
+        self.mana_relocate_time = 0.0  # time.monotonic() of the next search while the bar is lost
+        self.last_mana_percent = None
 
         # Thresholds for when to use potions (0.0 to 1.0)
-        self.health_threshold = 0.5  # Use health potion when below 50%
-        # self.mana_threshold = 0.5    # Use mana potion when below 50% - WIP
+        self.health_threshold = health_config["potion_threshold"]  # Use health potion when below 50%
+        # (health ratio at or below, potions to use), checked from the lowest level up
+        self.health_potion_levels = sorted((float(level), int(count)) for level, count in health_config["potion_levels"])
+        self.mana_threshold = mana_config["potion_threshold"]  # Use mana potion when below 50%
         
         # Empty health detection state
-        self.empty_health_detected = False
         self.empty_health_count = 0
         self.last_empty_health_message = 0  # For rate limiting messages
         
-        # Respawn system state
-        self.is_dead = False
-        self.respawn_wait_start = None
-        self.respawn_wait_duration = 7.5  # Wait 7.5 seconds before clicking respawn
-        self.post_respawn_heal_time = None
-        self.post_respawn_heal_duration = 3.0  # Heal for 3 seconds after respawn
+        # Death/respawn state machine: waits and polls are deadlines on time.monotonic()
+        respawn_config = self.config["respawn"]
+        self.life = LifeStateMachine(
+            respawn_wait=respawn_config["wait"],
+            poll_interval=respawn_config["poll_interval"],
+            heal_duration=respawn_config["heal_duration"],
+            probe_interval=respawn_config["probe_interval"],
+        )
+        self.post_respawn_potions = respawn_config["heal_potions"]
+
+        # Locked ROIs, UI scale and tuned thresholds from an earlier session (one file per instance),
+        # and the detector scores of this one for tuning
+        calibration_config = self.config["calibration"]
+        cache_path = self.config.resolve(calibration_config["path"])
+        if cache_path and name:
+            root, ext = os.path.splitext(cache_path)
+            cache_path = f"{root}.{name}{ext}"
+        self.calibration_cache = CalibrationCache(cache_path) if cache_path else None
+        self.tune_thresholds = calibration_config["tune"] if calibrate is None else calibrate
+        self.scores = ScoreRecorder()
+        self.tuned_thresholds = {}
+
+        # Potions take a moment to show on the bar; keep detecting but don't re-use them meanwhile
+        self.potion_effect_delay = 1.5
+        self.post_respawn_potion_delay = 2.0
+        self.potion_ready_time = 0.0  # time.monotonic() after which potions may be used again
+        self.potions_in_flight = 0  # Health potions queued since the cooldown began, not yet shown on the bar
+        self._potions_blocked_logged = False  # Warned once that potions cannot be sent
+
+        # Health rate from the recent readings; "predictive" healing uses it to heal ahead of
+        # expected threshold crossings with bursts sized by the predicted damage
+        healing_config = self.config["healing"]
+        self.health_trend = HealthRateEstimator(
+            window=healing_config["window"], min_samples=healing_config["min_samples"]
+        )
+        self.healer = None
+        if healing_config["mode"] == "predictive":
+            self.healer = PredictiveHealer(
+                self.health_trend,
+                threshold=self.health_threshold,
+                lead_time=healing_config["lead_time"],
+                target=healing_config["target"],
+                heal_per_potion=healing_config["heal_per_potion"],
+                max_burst=healing_config["max_burst"],
+                horizon=self.potion_effect_delay,
+                critical=healing_config["critical"],
+            )
+        elif healing_config["mode"] != "levels":
+            raise ValueError(f"Unknown healing mode '{healing_config['mode']}' (use 'predictive' or 'levels')")
+        self.mana_potion_delay = mana_config["potion_delay"]
+        self.mana_ready_time = 0.0
+        self.potion_counts = {"health": 0, "mana": 0}  # Potions queued this session, by input tag
+        self.session_started = None  # time.monotonic() of start_session
+
+        # All key presses and clicks go through one background input worker; keys go to the
+        # focused window unless a per-window `keys` sender is given (or are refused by `keys_blocked`)
+        self.input = InputDispatcher(debug_mode=self.debug_mode, metrics=self.metrics, log=self.log,
+                                     keys=keys, keys_blocked=keys_blocked)
 
         # Key bindings
-        self.health_potion_key = "1"  # Key 1 for health potion
-        # self.mana_potion_key = '2'    # Key 2 for mana potion - WIP
-        self.skill_keys = ["3", "4", "5", "6"]
-
-        # Mana functionality commented out for now - WIP
-        # self.mana_color_range = {
-        #     'lower': np.array([100, 100, 100]),  # Blue lower bound
-        #     'upper': np.array([130, 255, 255])   # Blue upper bound
-        # }
-
-        # Safety settings
-        pyautogui.FAILSAFE = True
-        pyautogui.PAUSE = 0.1
-        
-        # Configure screenshot tool for Linux
-        if platform.system() == "Linux" and self.debug_mode:
-            print("DEBUG: Running on Linux, will use scrot for screenshots")
+        self.health_potion_key = self.config["keys"]["health_potion"]
+        self.mana_potion_key = self.config["keys"]["mana_potion"]
+        self.skill_keys = list(self.config["keys"]["skills"])
+
+        # Skill rotation on cooldowns, queued behind heals on the same input worker
+        skills_config = self.config["skills"]
+        self.skills_enabled = skills_config["enabled"] if skills is None else skills
+        rotation = skills_config["rotation"] or [
+            {"key": key, "cooldown": skills_config["default_cooldown"], "priority": index}
+            for index, key in enumerate(self.skill_keys)
+        ]
+        self.skill_rotation = SkillRotation(
+            [Skill(s["key"], s.get("cooldown", skills_config["default_cooldown"]), s.get("priority", 0))
+             for s in rotation],
+            self.input,
+            global_cooldown=skills_config["global_cooldown"],
+        )
+
+        # In-memory screen capture (X11 MIT-SHM on Linux, native APIs elsewhere),
+        # or only the game window when one is given
+        if capture_backend is None:
+            window = window or self.config["capture"]["window"]
+            if window:
+                capture_backend = create_window_capture(window, debug_mode=self.debug_mode)
+            else:
+                capture_backend = create_capture_backend(debug_mode=self.debug_mode)
+        self.capture = capture_backend
 
     def load_health_templates(self):
         """Load pre-captured health bar images as templates"""
-        print(
-            f"DEBUG: Starting to load health templates from: {self.health_images_path}"
-        )
-        template_files = {
-            "20": "20_health_bar.png",
-            "40": "40_health_bar.png",
-            "50": "50_health_bar.png",
-            "full": "full_health_bar.png",
-        }
+        self.log.debug("Starting to load health templates from: {}", self.health_images_path)
+        template_files = self.config.detector("health")["levels"]
 
-        print(f"DEBUG: Looking for templates: {list(template_files.values())}")
+        self.log.debug("Looking for templates: {}", list(template_files.values()))
 
         for percentage, filename in template_files.items():
-            filepath = os.path.join(self.health_images_path, filename)
-            print(f"DEBUG: Checking file: {filepath}")
-
-            if os.path.exists(filepath):
-                # Try multiple ways to load the image
-                template = cv2.imread(filepath)
-                if template is not None:
-                    self.health_templates[percentage] = template
-                    print(
-                        f"SUCCESS: Loaded health template: {percentage}% - {filename} (shape: {template.shape})"
-                    )
-
-                    # Also verify the image can be used with PyAutoGUI
-                    try:
-                        test_img = Image.open(filepath)
-                        print(
-                            f"DEBUG: PIL can also load {filename} (size: {test_img.size})"
-                        )
-                    except Exception as e:
-                        print(f"WARNING: PIL cannot load {filename}: {e}")
-
-                else:
-                    print(
-                        f"ERROR: Could not load {filename} - cv2.imread returned None"
-                    )
-                    # Try with PIL as backup
-                    try:
-                        pil_img = Image.open(filepath)
-                        template = cv2.cvtColor(np.array(pil_img), cv2.COLOR_RGB2BGR)
-                        self.health_templates[percentage] = template
-                        print(
-                            f"SUCCESS: Loaded via PIL: {percentage}% - {filename} (shape: {template.shape})"
-                        )
-                    except Exception as e:
-                        print(f"ERROR: PIL also failed for {filename}: {e}")
-            else:
-                print(f"ERROR: Template file not found: {filepath}")
-
-        print(f"DEBUG: Total templates loaded: {len(self.health_templates)}")
+            # Register + get reuses templates another instance already loaded into a shared store
+            self.template_store.register(f"health_{percentage}", filename)
+            template = self.template_store.get(f"health_{percentage}", self.ui_scale)
+            if template is not None:
+                self.health_templates[percentage] = template
+                self.log.info("SUCCESS: Loaded health template: {}% - {} (shape: {})", percentage, filename, template.shape)
+
+        self.log.debug("Total templates loaded: {}", len(self.health_templates))
         if not self.health_templates:
-            print("CRITICAL ERROR: No health templates loaded! Check your images folder.")
+            self.log.error("CRITICAL: No health templates loaded! Check your images folder.")
 
     def load_respawn_templates(self):
         """Load empty health bar and respawn button templates"""
-        print("DEBUG: Loading respawn system templates...")
+        self.log.debug("Loading respawn system templates...")
         
-        # Load empty health bar template
-        empty_health_path = os.path.join(self.health_images_path, "empty_health_bar.png")
-        if os.path.exists(empty_health_path):
-            self.empty_health_template = cv2.imread(empty_health_path)
-            if self.empty_health_template is not None:
-                print(f"SUCCESS: Loaded empty health template (shape: {self.empty_health_template.shape})")
-            else:
-                print("ERROR: Could not load empty_health_bar.png")
-        else:
-            print("ERROR: empty_health_bar.png not found")
-            
-        # Load respawn button template
-        respawn_path = os.path.join(self.health_images_path, "respawn_button.png")
-        if os.path.exists(respawn_path):
-            self.respawn_button_template = cv2.imread(respawn_path)
-            if self.respawn_button_template is not None:
-                print(f"SUCCESS: Loaded respawn button template (shape: {self.respawn_button_template.shape})")
-            else:
-                print("ERROR: Could not load respawn_button.png")
+        # Load empty health bar template (the fill-ratio estimator needs it right away)
+        empty_file = self.config.detector("empty_health")["template"]
+        self.template_store.register("empty_health", empty_file)
+        self.empty_health_template = self.template_store.get("empty_health", self.ui_scale)
+        if self.empty_health_template is not None:
+            self.log.info("SUCCESS: Loaded empty health template (shape: {})", self.empty_health_template.shape)
         else:
-            print("ERROR: respawn_button.png not found")
-    
-    def _take_screenshot_with_scrot(self):
-        """Take screenshot using scrot directly"""
-        import subprocess
-        import tempfile
-        import time
-        
+            self.log.error("Could not load {}", empty_file)
+
+        # Respawn button template is only decoded when a respawn search first needs it
+        self.template_store.register("respawn_button", self.config.detector("respawn_button")["template"])
+
+    @property
+    def respawn_button_template(self):
+        return self.template_store.get("respawn_button", self.ui_scale)
+
+    def _create_health_estimator(self):
+        """Build the fill-ratio estimator from the full and empty bar templates"""
+        full_template = self.health_templates.get("full")
+        if full_template is None or self.empty_health_template is None:
+            self.log.warning("Full/empty health templates missing, using template voting only")
+            return None
         try:
-            # Create a named temporary file
-            tmp_path = f"/tmp/screenshot_{int(time.time())}.png"
-            
-            # Use scrot to take screenshot
-            cmd = ['scrot', tmp_path]
-            result = subprocess.run(cmd, capture_output=True, text=True, timeout=5)
-            
-            if result.returncode != 0:
-                print(f"DEBUG: scrot stderr: {result.stderr}")
-                print(f"DEBUG: scrot stdout: {result.stdout}")
-                raise Exception(f"scrot failed with code {result.returncode}")
-            
-            # Small delay to ensure file is written
-            time.sleep(0.05)
-            
-            # Check if file exists and has content
-            if not os.path.exists(tmp_path):
-                raise Exception(f"Screenshot file not created: {tmp_path}")
-            
-            file_size = os.path.getsize(tmp_path)
-            if file_size == 0:
-                raise Exception(f"Screenshot file is empty: {tmp_path}")
-            
-            # Load the image with PIL
-            from PIL import Image
-            img = Image.open(tmp_path)
-            
-            # Clean up temp file immediately
-            try:
-                os.unlink(tmp_path)
-            except:
-                pass
-            
-            if self.debug_mode:
-                print(f"DEBUG: scrot screenshot successful, size: {img.size}")
-            return img
-            
-        except Exception as e:
+            return FillRatioEstimator(full_template.bgr, self.empty_health_template.bgr)
+        except ValueError as e:
+            self.log.warning("Cannot use fill-ratio health estimation: {}", e)
+            return None
+
+    def _estimate_health(self, frame):
+        """Continuous health ratio read from the locked bar ROI, None if the fast path is unusable"""
+        if self.health_estimator is None or not self.health_roi.locked:
+            return None
+        if self._last_health_estimate[0] is frame:
+            return self._last_health_estimate[1]
+
+        region = self.health_roi.region
+        crop = frame.crop(region)
+        health_ratio = None
+        if crop.shape[:2] == (region[3], region[2]):
+            bar = crop.bgr
+            with self.metrics.timer("estimate_health"):
+                fill, confidence = self.health_estimator.estimate(bar)
+            self.scores.record("health_confidence", confidence)
+            if self.health_estimator.is_confident(confidence):
+                health_ratio = fill
+            elif self.debug_mode:
+                self.log.debug("Fill estimate rejected (confidence {:.3f})", confidence, every=1.0)
+            # The bar frame matching is what keeps the lock alive on the fast path
+            if not self.health_roi.update(region[:2], region[2:], confidence):
+                self.log.warning("Health bar lost - re-acquiring with a full-screen search")
+
+        self._last_health_estimate = (frame, health_ratio)
+        return health_ratio
+
+    def capture_frame(self, region=None):
+        """Capture one frame to be shared by every detector in this tick"""
+        if self.pipeline is not None:
+            return self.pipeline.request_frame(region)
+        return Frame.capture(self.capture, region, self.metrics)
+
+    def tick_region(self):
+        """Region captured every tick: the locked health ROI (plus the mana bar), or None for the full screen"""
+        region = self.health_roi.search_region(self.capture.screen_size())
+        if region is not None and self.mana_roi.locked:
+            region = union_region(region, self.mana_roi.region)
+        return region
+
+    def capture_tick_frame(self):
+        """Capture only the locked health ROI when possible, the full screen otherwise"""
+        if self.pipeline is not None:
+            return self.pipeline.next_frame()
+        return self.capture_frame(self.tick_region())
+
+    def _health_search_frame(self, frame):
+        """Restrict a frame to the locked health bar ROI (no-op while unlocked)"""
+        region = self.health_roi.search_region(self.capture.screen_size())
+        if region is None:
+            return frame
+        return frame.crop(region)
+
+    def calibrate_health_roi(self, frame=None):
+        """Find the health bar with a full-screen search and lock the ROI around it.
+
+        Every precomputed UI scale is tried (the active one first) until one
+        matches confidently; that scale is then the only one matched later.
+        """
+        if frame is None:
+            frame = self.capture_frame()
+
+        best_scale, best_score = self.ui_scale, -1.0
+        for scale in self.template_store.scales_by_preference(self.ui_scale):
+            self.apply_template_scale(scale)
+            self.health_roi.release()
+            self.get_health_percentage(frame)
+            score = self.last_health_match[1]
             if self.debug_mode:
-                print(f"ERROR: scrot screenshot failed: {e}")
-            # Clean up temp file if it exists
-            if 'tmp_path' in locals() and os.path.exists(tmp_path):
-                try:
-                    os.unlink(tmp_path)
-                except:
-                    pass
-            raise Exception(f"Screenshot failed: {e}")
-
-    def press_key(self, key, duration=0.1):
-        """Function to press key after some duration"""
-        print(f"DEBUG: Pressing key '{key}' for {duration} seconds...")
+                self.log.debug("UI scale {}: best health template score {:.3f}", scale, score)
+            if self.health_roi.locked and score >= self.health_cascade.accept:
+                best_scale = scale
+                break
+            if self.health_roi.locked and score > best_score:
+                best_scale, best_score = scale, score
+
+        if best_scale != self.ui_scale or not self.health_roi.locked:
+            self.apply_template_scale(best_scale)
+            self.health_roi.release()
+            self.get_health_percentage(frame)
+
+        if self.health_roi.locked:
+            self.log.info("🎯 Health bar locked at {} (UI scale {})", self.health_roi.region, self.ui_scale)
+        else:
+            self.log.warning("Health bar not found at any UI scale, will keep searching the full screen")
+        return self.health_roi.locked
+
+    def apply_template_scale(self, scale):
+        """Switch every template user to the variants for UI scale `scale`"""
+        if scale == self.ui_scale and self.health_estimator is not None:
+            return
+        if scale not in self.template_store.ui_scales:
+            raise ValueError(f"UI scale {scale} is not precomputed (have {self.template_store.ui_scales})")
+        self.ui_scale = scale
+        for percentage in self.health_templates:
+            self.health_templates[percentage] = self.template_store.get(f"health_{percentage}", scale)
+        self.empty_health_template = self.template_store.get("empty_health", scale)
+        self.health_estimator = self._create_health_estimator()
+        self._last_health_estimate = (None, None)
+        self.health_gate.reset()
+        self._gated_health = None
+        self.respawn_gate.reset()
+        self.respawn_roi.release()
+
+    def restore_calibration(self):
+        """Lock the ROIs and UI scale cached by an earlier session; True when the health bar is still there"""
+        if self.calibration_cache is None:
+            return False
+        data = self.calibration_cache.load(self.capture.screen_size(), self.capture.name)
+        if data is None or not data.get("health_roi") or data.get("ui_scale") not in self.template_store.ui_scales:
+            return False
+
+        self.apply_template_scale(data["ui_scale"])
+        self.tuned_thresholds = dict(data.get("thresholds") or {})
+        self.apply_thresholds(self.tuned_thresholds)
+        region = data["health_roi"]
+        self.health_roi.lock(region[:2], region[2:], self.health_roi.lock_threshold)
+        if data.get("mana_roi") and self.mana_estimator is not None and self.mana_region is None:
+            self.mana_roi.lock(data["mana_roi"][:2], data["mana_roi"][2:], 1.0)
+        if data.get("respawn_roi"):
+            self.respawn_roi.lock(data["respawn_roi"][:2], data["respawn_roi"][2:], self.respawn_threshold)
+        if self.mana_region is not None:
+            self.calibrate_mana_roi()
+
+        # One ROI capture confirms the bar has not moved since
+        if not self._verify_health_roi(self.capture_frame(self.tick_region())):
+            self.log.info("Cached health bar position no longer matches, searching the full screen")
+            self.health_roi.release()
+            self.mana_roi.release()
+            self.respawn_roi.release()
+            return False
+        self.log.info("⚡ Health bar restored at {} (UI scale {}) from the calibration cache", self.health_roi.region, self.ui_scale)
+        return True
+
+    def _verify_health_roi(self, frame):
+        """True when the locked health ROI of `frame` still holds the bar"""
+        region = self.health_roi.region
+        crop = frame.crop(region)
+        if crop.shape[:2] != (region[3], region[2]):
+            return False
+        if self.health_estimator is not None:
+            _, confidence = self.health_estimator.estimate(crop.bgr)
+            return confidence >= self.health_roi.keep_threshold
+        self.match_health_template(self._health_search_frame(frame).gray)
+        return self.last_health_match[1] >= self.health_roi.keep_threshold
+
+    def save_calibration(self):
+        """Cache the locked ROIs, UI scale and tuned thresholds for the next start"""
+        if self.calibration_cache is None or not self.health_roi.locked:
+            return
         try:
-            from pynput.keyboard import Key, Controller
-            keyboard_controller = Controller()
-            keyboard_controller.press(key)
-            time.sleep(duration)
-            keyboard_controller.release(key)
-            time.sleep(0.1)
-            print(f"DEBUG: Key '{key}' pressed successfully")
-        except Exception as e:
-            print(f"ERROR: Failed to press key '{key}': {e}")
+            self.calibration_cache.save({
+                "screen_size": list(self.capture.screen_size()),
+                "capture": self.capture.name,
+                "ui_scale": self.ui_scale,
+                "health_roi": list(self.health_roi.region),
+                "mana_roi": list(self.mana_roi.region) if self.mana_roi.locked else None,
+                "respawn_roi": list(self.respawn_roi.region) if self.respawn_roi.locked else None,
+                "thresholds": self.tuned_thresholds,
+            })
+        except OSError as e:
+            self.log.warning("Cannot write calibration cache {}: {}", self.calibration_cache.path, e)
+
+    def fit_thresholds(self):
+        """Thresholds fitted from this session's score distributions ({name: value}, only those with enough data)"""
+        fitted = {}
+        # Both absent and present scores show up over a session with a death: split them
+        for name in ("empty_health", "respawn_button"):
+            threshold = fit_separation(self.scores.scores(name))
+            if threshold is not None:
+                fitted[name] = threshold
+
+        # The bar is nearly always there: reject just under its weakest matches
+        health = self.scores.scores("health_match")
+        min_score = fit_separation(health)
+        if min_score is None:
+            min_score = fit_floor(health, margin=0.1)
+        if min_score is not None:
+            fitted["health_min_score"] = min(max(min_score, 0.1), self.health_cascade.accept)
+
+        # The ROI lock is kept alive by fill confidences on the fast path, template scores otherwise
+        keep_scores = self.scores.scores("health_confidence" if self.health_estimator is not None else "health_match")
+        keep = fit_floor(keep_scores)
+        if keep is not None:
+            fitted["roi_keep"] = min(max(keep, 0.2), self.health_roi.lock_threshold)
+        return fitted
+
+    def apply_thresholds(self, thresholds):
+        """Use fitted thresholds in place of the configured ones (unknown names are ignored)"""
+        if "empty_health" in thresholds:
+            self.empty_health_threshold = thresholds["empty_health"]
+        if "respawn_button" in thresholds:
+            self.respawn_threshold = thresholds["respawn_button"]
+            self.respawn_roi.lock_threshold = self.respawn_roi.keep_threshold = self.respawn_threshold
+        if "health_min_score" in thresholds:
+            self.health_cascade.reject = thresholds["health_min_score"]
+        if "roi_keep" in thresholds:
+            self.health_roi.keep_threshold = thresholds["roi_keep"]
+
+    def _update_health_roi(self, search_frame):
+        """Lock or track the health ROI from the last match made on `search_frame`"""
+        best_match, best_score, best_loc = self.last_health_match
+        if best_loc is None or best_match not in self.health_templates:
+            if self.health_roi.locked:
+                self.health_roi.update((0, 0), (0, 0), 0.0)
+            return
+
+        size = self.health_templates[best_match].size
+        screen_loc = search_frame.to_screen(*best_loc)
+        if self.health_roi.locked:
+            if not self.health_roi.update(screen_loc, size, best_score):
+                self.log.warning("Health bar lost - re-acquiring with a full-screen search")
+        elif self.health_roi.lock(screen_loc, size, best_score):
+            if self.debug_mode:
+                self.log.debug("Health ROI locked at {} (score {:.3f})", self.health_roi.region, best_score)
+
+    def press_key(self, key, duration=0.1, delay=0.0, priority=InputDispatcher.PRIORITY_DEFAULT, tag=None):
+        """Queue a key press on the input worker (returns immediately)"""
+        if self.debug_mode:
+            self.log.debug("Queueing key '{}' for {} seconds...", key, duration)
+        return self.input.press(key, duration, delay=delay, priority=priority, tag=tag)
+
+    def click(self, position, priority=InputDispatcher.PRIORITY_DEFAULT, tag=None):
+        """Queue a click at a detector position (translated to the screen for window instances)"""
+        # Window captures know where their window is now, even after it was moved
+        window_origin = getattr(self.capture, "window_origin", None)
+        origin = window_origin() if window_origin is not None else self.screen_origin
+        x = position[0] + origin[0]
+        y = position[1] + origin[1]
+        return self.input.click(x, y, priority=priority, tag=tag)
+
+    def _potion_keys_blocked(self):
+        """True (warning once) when this instance may not press keys, so no potion is counted"""
+        if not self.input.keys_blocked:
+            return False
+        if not self._potions_blocked_logged:
+            self._potions_blocked_logged = True
+            self.log.warning("Potions disabled: {}", self.input.keys_blocked)
+        return True
+
+    def use_potion_burst(self, key, count, spacing, tag="health"):
+        """Queue `count` potion presses `spacing` seconds apart; returns when the last one fires.
+
+        Returns None without queueing or counting anything while keys are blocked.
+        """
+        if self._potion_keys_blocked():
+            return None
+        self.input.burst(key, count, spacing, priority=InputDispatcher.PRIORITY_HEAL, tag=tag)
+        self.potion_counts[tag] = self.potion_counts.get(tag, 0) + count
+        if tag == "health":
+            self.potions_in_flight += count
+        return time.monotonic() + (count - 1) * spacing
 
     # Screenshot functionality commented out - using pre-captured images instead
     # def capture_screen_region(self, region):
@@ -235,420 +583,479 @@ class GameAutomation:
     def match_health_template(self, screen_image):
         """Match current screen with health bar templates to determine health percentage"""
         if self.debug_mode:
-            print(f"DEBUG: Starting template matching...")
+            self.log.debug("Starting template matching...")
 
         if not self.health_templates:
             if self.debug_mode:
-                print("ERROR: No health templates loaded!")
+                self.log.error("No health templates loaded!")
             return 1.0
 
         if self.debug_mode:
-            print(f"DEBUG: Screen image shape: {screen_image.shape}")
+            self.log.debug("Screen image shape: {}", screen_image.shape)
 
-        best_match = None
-        best_score = 0
-        all_scores = {}
-        min_threshold = 0.3  # Minimum confidence threshold
+        min_threshold = self.health_cascade.reject  # Minimum confidence threshold
 
         # Convert screen image to same format as templates
         if len(screen_image.shape) == 3:
             screen_gray = cv2.cvtColor(screen_image, cv2.COLOR_BGR2GRAY)
             if self.debug_mode:
-                print(f"DEBUG: Converted screen to grayscale, shape: {screen_gray.shape}")
+                self.log.debug("Converted screen to grayscale, shape: {}", screen_gray.shape)
         else:
             screen_gray = screen_image
             if self.debug_mode:
-                print(f"DEBUG: Screen already grayscale, shape: {screen_gray.shape}")
+                self.log.debug("Screen already grayscale, shape: {}", screen_gray.shape)
 
-        # Try both PyAutoGUI and OpenCV approaches
-        if self.debug_mode:
-            print(f"DEBUG: Testing {len(self.health_templates)} templates...")
+        # Large (full-screen) searches go coarse-to-fine with one shared downscale,
+        # small ROI crops are matched directly at full resolution
+        sample = next(iter(self.health_templates.values()))
+        use_pyramid = screen_gray.size > 16 * sample.gray.size
+        coarse = None
+        if use_pyramid and self.pyramid_matcher.can_downscale(sample):
+            coarse = downscale(screen_gray, self.pyramid_matcher.scale)
 
-        # Method 1: Try PyAutoGUI locateOnScreen for each template (only in debug mode)
+        order = self._health_template_order()
         if self.debug_mode:
-            for percentage, template in self.health_templates.items():
-                template_filename = (
-                    f"images/{percentage}_health_bar.png"
-                    if percentage not in ["empty", "full"]
-                    else f"images/{percentage}_health_bar.png"
-                )
-                if percentage == "empty":
-                    template_filename = "images/empty_health_bar.png"
-                elif percentage == "full":
-                    template_filename = "images/full_health_bar.png"
-
-                print(
-                    f"DEBUG: Testing PyAutoGUI for {percentage}% using {template_filename}"
-                )
+            self.log.debug("Testing templates in order {}...", order)
 
-                try:
-                    if os.path.exists(template_filename):
-                        # Try multiple confidence levels
-                        for confidence in [0.9, 0.8, 0.7, 0.6, 0.5]:
-                            try:
-                                location = pyautogui.locateOnScreen(
-                                    template_filename, confidence=confidence
-                                )
-                                if location:
-                                    print(
-                                        f"DEBUG: PyAutoGUI found {percentage}% at confidence {confidence}: {location}"
-                                    )
-                                    all_scores[f"{percentage}_pyautogui"] = confidence
-                                    if confidence > best_score:
-                                        best_score = confidence
-                                        best_match = percentage
-                                    break
-                            except pyautogui.ImageNotFoundException:
-                                continue
-                            except Exception as e:
-                                print(
-                                    f"DEBUG: PyAutoGUI error for {percentage}% at confidence {confidence}: {e}"
-                                )
-                                continue
-                except Exception as e:
-                    print(f"DEBUG: PyAutoGUI setup error for {percentage}%: {e}")
-
-        # Method 2: OpenCV template matching (optimized - use only one method)
-        for percentage, template in self.health_templates.items():
+        best_match = None
+        best_loc = None
+        try:
+            template, best_score, best_loc, all_scores = self.health_cascade.match(
+                screen_gray, [self.health_templates[p] for p in order], coarse, pyramid=use_pyramid
+            )
+            self.scores.record("health_match", best_score)
+            if template is not None and best_score > min_threshold:
+                best_match = next(p for p in order if self.health_templates[p] is template)
+            else:
+                best_loc = None
             if self.debug_mode:
-                print(
-                    f"DEBUG: Testing OpenCV for template {percentage}% (shape: {template.shape})"
-                )
-
-            try:
-                template_gray = cv2.cvtColor(template, cv2.COLOR_BGR2GRAY)
-                if self.debug_mode:
-                    print(
-                        f"DEBUG: Template {percentage}% converted to grayscale, shape: {template_gray.shape}"
-                    )
-
-                # Use only the most reliable method for better performance
-                method = cv2.TM_CCOEFF_NORMED
-                method_name = "CCOEFF_NORMED"
-
-                try:
-                    result = cv2.matchTemplate(screen_gray, template_gray, method)
-                    _, max_val, _, max_loc = cv2.minMaxLoc(result)
-                    match_val = max_val
-                    match_loc = max_loc
-
-                    score_key = f"{percentage}_{method_name}"
-                    all_scores[score_key] = match_val
-                    
-                    if self.debug_mode:
-                        print(
-                            f"DEBUG: Template {percentage}% {method_name} score: {match_val:.4f} at location {match_loc}"
-                        )
-
-                    # Use best score from any method
-                    if match_val > best_score and match_val > min_threshold:
-                        best_score = match_val
-                        best_match = percentage
-                        if self.debug_mode:
-                            print(
-                                f"DEBUG: New best match: {percentage}% with {method_name} score {match_val:.4f}"
-                            )
-
-                except Exception as e:
-                    if self.debug_mode:
-                        print(
-                            f"ERROR: OpenCV {method_name} failed for template {percentage}%: {e}"
-                        )
-
-            except Exception as e:
-                if self.debug_mode:
-                    print(f"ERROR: Failed to process template {percentage}%: {e}")
+                self._debug_match_report(screen_gray, {f"{p}%": self.health_templates[p] for p in order})
+        except Exception as e:
+            best_score, all_scores = 0.0, {}
+            if self.debug_mode:
+                self.log.error("OpenCV template cascade failed: {}", e)
 
         if self.debug_mode:
-            print(f"DEBUG: All match scores: {all_scores}")
-            print(f"DEBUG: Best match: {best_match}% with score {best_score:.4f}")
+            self.log.debug("All match scores: {} ({} skipped)", all_scores, len(order) - len(all_scores))
+            self.log.debug("Best match: {}% with score {:.4f}", best_match, best_score)
+
+        self.last_health_match = (best_match, best_score, best_loc)
 
         # Only use result if confidence is high enough
         if best_score < min_threshold:
             if self.debug_mode:
-                print(
-                    f"WARNING: Best match score {best_score:.4f} below threshold {min_threshold}, defaulting to full health"
+                self.log.warning(
+                    "Best match score {:.4f} below threshold {}, defaulting to full health", best_score, min_threshold
                 )
             return 1.0
 
         # Convert percentage string to float
-        if best_match == 'full':
-            result_percent = 1.0
-        elif best_match == 'empty':
-            result_percent = 0.0
-        elif best_match in ['20', '40', '50']:
-            result_percent = int(best_match) / 100.0
-        else:
+        result_percent = self._template_health(best_match)
+        if result_percent is None:
             result_percent = 1.0  # Default to full health if no good match
             if self.debug_mode:
-                print(f"WARNING: No good template match found, defaulting to full health")
+                self.log.warning("No good template match found, defaulting to full health")
 
         if self.debug_mode:
-            print(f"DEBUG: Final health percentage: {result_percent:.2%}")
+            self.log.debug("Final health percentage: {:.2%}", result_percent)
         return result_percent
 
-    def get_health_percentage(self):
+    @staticmethod
+    def _template_health(percentage):
+        """Health ratio a template key stands for, None if it is not a health level"""
+        if percentage == 'full':
+            return 1.0
+        if percentage == 'empty':
+            return 0.0
+        if percentage is not None and percentage.isdigit():
+            return int(percentage) / 100.0
+        return None
+
+    def _health_template_order(self):
+        """Health template keys, closest to the last matched level first (full health when unknown)"""
+        last = self._template_health(self.last_health_match[0])
+        if last is None:
+            last = 1.0
+        return sorted(
+            self.health_templates,
+            key=lambda p: (abs((self._template_health(p) or 0.0) - last), -(self._template_health(p) or 0.0)),
+        )
+
+    def _debug_match_report(self, image, templates):
+        """Report every template at each debug confidence level from its own full-resolution map.
+
+        Maps the tick's match already computed on `image` are reused; templates it
+        only refined, pruned or never reached are correlated once here.
+        """
+        for name, template in templates.items():
+            result = self.pyramid_matcher.full_result(image, template)
+            if result is None:
+                self.log.debug("{} larger than the search image, not matched", name)
+                continue
+            _, score, _, location = cv2.minMaxLoc(result)
+            levels = confidence_levels(result, DEBUG_CONFIDENCE_LEVELS)
+            passed = " ".join(
+                f"{level}:{'✓' if score >= level else '✗'}({count})" for level, count in levels.items()
+            )
+            self.log.debug("{} score {:.4f} at {} | level:pass(locations) {}", name, score, location, passed)
+
+    def get_health_percentage(self, frame=None):
         """Get current health percentage using template matching"""
-        if self.debug_mode:
-            print(f"DEBUG: Taking screenshot...")
-        
         try:
-            # Use scrot directly for Linux systems
-            if platform.system() == "Linux":
-                screenshot = self._take_screenshot_with_scrot()
-                if self.debug_mode:
-                    print(f"DEBUG: Screenshot taken with scrot, size: {screenshot.size}")
-            else:
-                screenshot = pyautogui.screenshot()
+            if frame is None:
                 if self.debug_mode:
-                    print(f"DEBUG: Screenshot taken with pyautogui, size: {screenshot.size}")
-            
-            screen_image = cv2.cvtColor(np.array(screenshot), cv2.COLOR_RGB2BGR)
+                    self.log.debug("Taking screenshot...")
+                frame = self.capture_frame()
             if self.debug_mode:
-                print(f"DEBUG: Screenshot converted to OpenCV format, shape: {screen_image.shape}")
+                self.log.debug("Using frame from {}, shape: {}", self.capture.name, frame.shape)
 
-            # Optional: Save screenshot for debugging (only in debug mode)
-            if self.debug_mode:
-                cv2.imwrite("debug_screenshot.png", screen_image)
-                print(f"DEBUG: Screenshot saved as debug_screenshot.png")
-
-                # Also save a smaller region if templates are small
-                if self.health_templates:
-                    # Get template size for reference
-                    sample_template = next(iter(self.health_templates.values()))
-                    th, tw = sample_template.shape[:2]
-                    print(f"DEBUG: Template reference size: {tw}x{th}")
-
-                    # Save multiple regions for testing
-                    regions_to_test = [
-                        (0, 0, tw * 3, th * 3),  # Top-left corner
-                        (
-                            screen_image.shape[1] // 4,
-                            screen_image.shape[0] // 4,
-                            tw * 3,
-                            th * 3,
-                        ),  # Quarter screen
-                        (
-                            screen_image.shape[1] // 2,
-                            screen_image.shape[0] // 2,
-                            tw * 3,
-                            th * 3,
-                        ),  # Center
-                    ]
-
-                    for i, (x, y, w, h) in enumerate(regions_to_test):
-                        x = max(0, min(x, screen_image.shape[1] - w))
-                        y = max(0, min(y, screen_image.shape[0] - h))
-                        w = min(w, screen_image.shape[1] - x)
-                        h = min(h, screen_image.shape[0] - y)
-
-                        region = screen_image[y : y + h, x : x + w]
-                        cv2.imwrite(f"debug_region_{i}.png", region)
-                        print(f"DEBUG: Saved test region {i} as debug_region_{i}.png")
-
-            # Match with health templates
-            health_percent = self.match_health_template(screen_image)
+            # Fast path: read the fill ratio straight from the locked bar
+            health_ratio = self._estimate_health(frame)
+            if health_ratio is not None:
+                if self.debug_mode:
+                    self.log.debug("Fill-ratio health estimate: {:.2%}", health_ratio)
+                return health_ratio
+
+            # Match with health templates, only inside the ROI once it is locked
+            search_frame = self._health_search_frame(frame)
+            health_percent = self.match_health_template(search_frame.gray)
+            self._update_health_roi(search_frame)
             return health_percent
 
         except Exception as e:
-            print(f"ERROR: Failed to get health percentage: {e}")
+            self.log.error("Failed to get health percentage: {}", e)
             return 1.0
 
-    # Mana functionality commented out - WIP
-    # def get_mana_percentage(self):
-    #     """Get current mana percentage - WIP"""
-    #     # This will be implemented later with mana bar images
-    #     return 1.0
+    def calibrate_mana_roi(self, frame=None):
+        """Lock the mana ROI from the config region, or find the bar by colour near the health bar"""
+        if self.mana_estimator is None:
+            return False
+        self.mana_roi.release()
+        if self.mana_region is not None:
+            self.mana_roi.lock(self.mana_region[:2], self.mana_region[2:], 1.0)
+        else:
+            if frame is None:
+                frame = self.capture_frame()
+            near = self.health_roi.region[:2] if self.health_roi.locked else None
+            with self.metrics.timer("locate_mana"):
+                region = self.mana_estimator.locate(frame.bgr, near=near)
+            if region is not None:
+                x, y = frame.to_screen(region[0], region[1])
+                if near is None or abs(x - near[0]) + abs(y - near[1]) <= self.mana_max_distance:
+                    self.mana_roi.lock((x, y), region[2:], 1.0)
+
+        if self.mana_roi.locked:
+            self.log.info("🎯 Mana bar locked at {}", self.mana_roi.region)
+        else:
+            self.log.warning("Mana bar not found, retrying every {:.0f}s (set detectors.mana.region to fix it)",
+                             self.mana_relocate_interval)
+            self.mana_relocate_time = time.monotonic() + self.mana_relocate_interval
+        return self.mana_roi.locked
+
+    def get_mana_percentage(self, frame):
+        """Mana ratio read from the locked mana ROI of `frame`, None while it cannot be read"""
+        if self.mana_estimator is None:
+            return None
+        if not self.mana_roi.locked:
+            if time.monotonic() >= self.mana_relocate_time:
+                self.calibrate_mana_roi()  # Full-screen capture, rate limited while the bar is lost
+            return None
+
+        region = self.mana_roi.region
+        crop = frame.crop(region)
+        if crop.shape[:2] != (region[3], region[2]):
+            return None  # Frame does not cover the bar (the tick region grows next tick)
+        with self.metrics.timer("estimate_mana"):
+            fill, confidence = self.mana_estimator.estimate(crop.bgr)
+        if not self.mana_roi.update(region[:2], region[2:], confidence):
+            self.log.warning("Mana bar lost - searching for it again")
+            self.mana_relocate_time = time.monotonic() + self.mana_relocate_interval
+            return None
+        if not self.mana_estimator.is_confident(confidence):
+            if self.debug_mode:
+                self.log.debug("Mana estimate rejected (confidence {:.3f})", confidence, every=1.0)
+            return None
+        return fill
 
-    def is_health_empty(self):
+    def is_health_empty(self, frame=None):
         """Check if health bar is completely empty using dedicated template matching"""
+        if frame is None:
+            frame = self.capture_frame()
+
+        # Fast path: an empty bar is a fill ratio of (almost) zero
+        health_ratio = self._estimate_health(frame)
+        if health_ratio is not None:
+            return health_ratio <= self.empty_health_ratio
+
         if self.empty_health_template is None:
             # Fallback to percentage-based detection
-            health_percent = self.get_health_percentage()
+            health_percent = self.get_health_percentage(frame)
             if health_percent == 0.0:
                 if self.debug_mode:
-                    print("DEBUG: Health detected as exactly 0% (empty template matched)")
+                    self.log.debug("Health detected as exactly 0% (empty template matched)")
                 return True
             elif health_percent <= 0.01:  # Less than 1% could also indicate death
                 if self.debug_mode:
-                    print(f"DEBUG: Health extremely low ({health_percent:.2%}), treating as empty")
+                    self.log.debug("Health extremely low ({:.2%}), treating as empty", health_percent)
                 return True
             return False
             
         # Use template matching for empty health detection
         try:
-            screenshot = self._take_screenshot_with_scrot()
-            if screenshot is None:
-                return False
-                
-            # Convert screenshot to the same format as template
-            screenshot_cv = cv2.cvtColor(np.array(screenshot), cv2.COLOR_RGB2BGR)
-            
-            # Perform template matching
-            result = cv2.matchTemplate(screenshot_cv, self.empty_health_template, cv2.TM_CCOEFF_NORMED)
-            _, max_val, _, _ = cv2.minMaxLoc(result)
+            # Perform template matching (the empty bar sits where the health bar is)
+            search_frame = self._health_search_frame(frame)
+            max_val, max_loc = self.pyramid_matcher.time_full(search_frame.gray, self.empty_health_template)
+            self.scores.record("empty_health", max_val)
+            if self.debug_mode:
+                self._debug_match_report(search_frame.gray, {"empty health": self.empty_health_template})
             
-            # Consider it a match if confidence is above 0.7
-            is_empty = max_val > 0.7
+            # Consider it a match if confidence is above the configured threshold
+            is_empty = max_val > self.empty_health_threshold
             
             if self.debug_mode and is_empty:
-                print(f"DEBUG: Empty health bar detected with confidence: {max_val:.3f}")
+                self.log.debug("Empty health bar detected with confidence: {:.3f}", max_val)
                 
             return is_empty
             
         except Exception as e:
             if self.debug_mode:
-                print(f"DEBUG: Error in empty health detection: {e}")
+                self.log.debug("Error in empty health detection: {}", e)
             return False
 
-    def detect_respawn_button(self):
-        """Detect if respawn button is visible on screen"""
+    def _respawn_search_region(self):
+        """Region polled for the respawn button: the configured one, around the learnt button, or None"""
+        if self.respawn_region is not None:
+            return self.respawn_region
+        return self.respawn_roi.search_region(self.capture.screen_size())
+
+    def detect_respawn_button(self, frame=None):
+        """Detect if respawn button is visible on screen (only its ROI is captured once it is known)"""
         if self.respawn_button_template is None:
             return False, None
             
         try:
-            screenshot = self._take_screenshot_with_scrot()
-            if screenshot is None:
-                return False, None
-                
-            # Convert screenshot to the same format as template
-            screenshot_cv = cv2.cvtColor(np.array(screenshot), cv2.COLOR_RGB2BGR)
-            
-            # Perform template matching
-            result = cv2.matchTemplate(screenshot_cv, self.respawn_button_template, cv2.TM_CCOEFF_NORMED)
-            _, max_val, _, max_loc = cv2.minMaxLoc(result)
-            
-            # Consider it a match if confidence is above 0.8
-            if max_val > 0.8:
+            if frame is None:
+                frame = self.capture_frame(self._respawn_search_region())
+
+            # Whole frames go coarse-to-fine; only the small ROI is change-gated, the button
+            # is too small a part of the screen to move a whole-frame mean difference
+            template = self.respawn_button_template
+            full_search = self.pyramid_matcher.can_downscale(template) and frame.gray.size > 16 * template.gray.size
+            if not full_search:
+                if self.respawn_gate.unchanged(frame.gray, frame.timestamp):
+                    return self._gated_respawn
+                self.respawn_gate.update(frame.gray, frame.timestamp)
+                self._gated_respawn = (False, None)
+
+            if full_search:
+                max_val, max_loc = self.pyramid_matcher.match(
+                    frame.gray, template, frame.gray_scaled(self.pyramid_matcher.scale))
+            else:
+                max_val, max_loc = self.pyramid_matcher.time_full(frame.gray, template)
+            self.scores.record("respawn_button", max_val)
+
+            # Consider it a match if confidence is above the configured threshold
+            if max_loc is not None and max_val > self.respawn_threshold:
                 # Calculate center of the button
-                h, w = self.respawn_button_template.shape[:2]
-                center_x = max_loc[0] + w // 2
-                center_y = max_loc[1] + h // 2
+                w, h = template.size
+                center_x, center_y = frame.to_screen(max_loc[0] + w // 2, max_loc[1] + h // 2)
+                # The button shows up in the same place every death
+                self.respawn_roi.lock(frame.to_screen(*max_loc), (w, h), max_val)
                 
                 if self.debug_mode:
-                    print(f"DEBUG: Respawn button detected with confidence: {max_val:.3f} at ({center_x}, {center_y})")
-                    
-                return True, (center_x, center_y)
+                    self.log.debug("Respawn button detected with confidence: {:.3f} at ({}, {})", max_val, center_x, center_y)
+
+                self._gated_respawn = (True, (center_x, center_y))
+                return self._gated_respawn
             
             return False, None
             
         except Exception as e:
             if self.debug_mode:
-                print(f"DEBUG: Error in respawn button detection: {e}")
+                self.log.debug("Error in respawn button detection: {}", e)
             return False, None
 
-    def click_respawn_button(self):
+    def click_respawn_button(self, frame=None):
         """Click the respawn button if detected"""
-        button_found, button_pos = self.detect_respawn_button()
+        button_found, button_pos = self.detect_respawn_button(frame)
         
         if button_found and button_pos:
-            print(f"🔄 Clicking respawn button at position {button_pos}")
-            pyautogui.click(button_pos[0], button_pos[1])
-            time.sleep(1.0)  # Wait after clicking
+            self.log.info("🔄 Clicking respawn button at position {}", button_pos)
+            self.click(button_pos, priority=InputDispatcher.PRIORITY_RESPAWN, tag="respawn")
+            # Give the game a moment after clicking before the first potion
+            self.potion_ready_time = time.monotonic() + 1.0
             return True
         
         return False
 
-    def use_health_potion(self, force_heal=False):
+    def use_health_potion(self, force_heal=False, frame=None):
         """Function to heal when the bar decreases - uses multiple potions based on health level"""
         if self.debug_mode:
-            print("DEBUG: Checking health status...")
-            print(f"DEBUG: Health threshold set to: {self.health_threshold:.2%}")
+            self.log.debug("Checking health status...")
+            self.log.debug("Health threshold set to: {:.2%}", self.health_threshold)
+
+        potions_cooling_down = time.monotonic() < self.potion_ready_time
+        if not potions_cooling_down:
+            self.potions_in_flight = 0  # Every earlier burst has had time to land
 
         # Check if we're in post-respawn healing mode
         if force_heal:
+            if potions_cooling_down:
+                return False
             if self.debug_mode:
-                print("DEBUG: Force healing mode (post-respawn)")
-            potions_to_use = 2  # Use 2 potions after respawn
-            print(f"Post-respawn healing: Using {potions_to_use} health potion(s) (Key 1)...")
-            
-            for i in range(potions_to_use):
-                if self.debug_mode:
-                    print(f"  Pressing potion {i+1}/{potions_to_use}")
-                self.press_key(self.health_potion_key)
-                
-                # Wait between multiple potion presses (except after the last one)
-                if i < potions_to_use - 1:
-                    time.sleep(0.5)  # Slightly longer delay for post-respawn healing
-                    
-            # Wait for potions to take effect
-            time.sleep(2.0)  # Longer wait for post-respawn healing
+                self.log.debug("Force healing mode (post-respawn)")
+            potions_to_use = self.post_respawn_potions
+            # Slightly longer spacing between presses for post-respawn healing
+            last_press = self.use_potion_burst(self.health_potion_key, potions_to_use, spacing=0.5)
+            if last_press is None:
+                return False
+            self.log.info("Post-respawn healing: Using {} health potion(s) (Key {})...", potions_to_use, self.health_potion_key)
+
+            # Let potions take effect before the next burst (longer for post-respawn healing)
+            self.potion_ready_time = last_press + self.post_respawn_potion_delay
             if self.debug_mode:
-                print(f"DEBUG: Finished post-respawn healing with {potions_to_use} potion(s)")
+                self.log.debug("Finished post-respawn healing with {} potion(s)", potions_to_use)
             return True
 
+        # Both checks below look at the same frame
+        if frame is None:
+            frame = self.capture_frame()
+
+        empty, health_percent = self._read_health(frame)
+
         # First check if health is empty to avoid wasting potions
-        if self.is_health_empty():
-            if not self.empty_health_detected:  # Only show message on first detection
-                print("⚠️  EMPTY HEALTH BAR DETECTED - Character appears to be dead/incapacitated")
-                print("   Stopping potion usage to prevent waste. Waiting for revival...")
+        if empty:
+            if self.life.alive:  # Only show message on first detection
+                self.log.info("⚠️  EMPTY HEALTH BAR DETECTED - Character appears to be dead/incapacitated")
+                self.log.info("   Stopping potion usage to prevent waste. Waiting for revival...")
             return "empty"  # Special return value to indicate empty health
 
-        health_percent = self.get_health_percentage()
-        
+        self.last_health_percent = health_percent
+
+        self.scheduler.record_health(health_percent, frame.timestamp)
+        self.health_trend.add(frame.timestamp, health_percent)
+
         # Always show health percentage for monitoring
-        print(f"Health: {health_percent:.2%}")
+        self.log.info("Health: {:.2%}", health_percent, every=self.status_interval)
 
-        # Determine how many potions to use based on health level
-        potions_to_use = 0
-        
-        if health_percent <= 0.20:  # 20% or lower
-            potions_to_use = 4
+        if (potions_cooling_down and self.healer is not None
+                and self.healer.emergency(health_percent, pending=self.potions_in_flight)):
+            # Damage is outpacing even the potions still on their way, don't wait for them to land
             if self.debug_mode:
-                print(f"DEBUG: Critical health ({health_percent:.2%}) - using 4 potions")
-        elif health_percent <= 0.40:  # 40% or lower
-            potions_to_use = 2
+                self.log.debug("Health predicted critical, skipping potion cooldown")
+            potions_cooling_down = False
+
+        if potions_cooling_down:
             if self.debug_mode:
-                print(f"DEBUG: Low health ({health_percent:.2%}) - using 2 potions")
-        elif health_percent <= 0.50:  # 50% or lower
-            potions_to_use = 1
+                self.log.debug("Waiting for previous potions to take effect")
+            return False
+
+        with self.metrics.timer("decide"):
+            return self._decide_health_potions(health_percent)
+
+    def _read_health(self, frame):
+        """(empty, health ratio) of a frame, reusing the last result while the locked bar is unchanged"""
+        bar = None
+        if self.health_roi.locked:
+            region = self.health_roi.region
+            bar = frame.crop(region)
+            if bar.shape[:2] != (region[3], region[2]):
+                bar = None
+
+        if bar is not None and self._gated_health is not None:
+            with self.metrics.timer("gate"):
+                unchanged = self.health_gate.unchanged(bar.raw, frame.timestamp)
+            if unchanged:
+                return self._gated_health
+
+        empty = self.is_health_empty(frame)
+        health_percent = None if empty else self.get_health_percentage(frame)
+
+        # Only a result read from a still-locked bar may be reused
+        if bar is not None and self.health_roi.locked and self.health_roi.region == region:
+            self.health_gate.update(bar.raw, frame.timestamp)
+            self._gated_health = (empty, health_percent)
+        else:
+            self.health_gate.reset()
+            self._gated_health = None
+        return empty, health_percent
+
+    def _decide_health_potions(self, health_percent):
+        """Queue potions for the current (and, when predictive, expected) health; True if any were used"""
+        if self.healer is not None:
+            potions_to_use = self.healer.plan(health_percent, pending=self.potions_in_flight)
             if self.debug_mode:
-                print(f"DEBUG: Medium health ({health_percent:.2%}) - using 1 potion")
+                rate = self.health_trend.rate()
+                trend = f"{rate:+.2%}/s" if rate is not None else "unknown"
+                self.log.debug("Health {:.2%}, trend {} - using {} potion(s)", health_percent, trend, potions_to_use)
+            return self._queue_health_potions(potions_to_use)
+
+        # Determine how many potions to use based on health level
+        potions_to_use = 0
+        
+        for level, potions in self.health_potion_levels:
+            if health_percent <= level:
+                potions_to_use = potions
+                if self.debug_mode:
+                    self.log.debug("Health {:.2%} <= {:.0%} - using {} potion(s)", health_percent, level, potions)
+                break
         else:
             if self.debug_mode:
-                print(f"DEBUG: Health {health_percent:.2%} > 50%, no potion needed")
+                self.log.debug("Health {:.2%} > {:.0%}, no potion needed", health_percent, self.health_threshold)
             return False
+        return self._queue_health_potions(potions_to_use)
 
+    def _queue_health_potions(self, potions_to_use):
+        """Queue a burst of health potions and start the wait for them to take effect"""
         if potions_to_use > 0:
-            print(f"Using {potions_to_use} health potion(s) (Key 1)...")
-            
-            for i in range(potions_to_use):
-                if self.debug_mode:
-                    print(f"  Pressing potion {i+1}/{potions_to_use}")
-                self.press_key(self.health_potion_key)
-                
-                # Wait between multiple potion presses (except after the last one)
-                if i < potions_to_use - 1:
-                    time.sleep(0.3)  # Short delay between potions
-                    
-            # Wait for potions to take effect
-            time.sleep(1.5)
+            # Short spacing between potions; detection keeps running meanwhile
+            last_press = self.use_potion_burst(self.health_potion_key, potions_to_use, spacing=0.3)
+            if last_press is None:
+                return False
+            self.log.info("Using {} health potion(s) (Key {})...", potions_to_use, self.health_potion_key)
+
+            # Let potions take effect before deciding again
+            self.potion_ready_time = last_press + self.potion_effect_delay
             if self.debug_mode:
-                print(f"DEBUG: Finished using {potions_to_use} potion(s)")
+                self.log.debug("Finished using {} potion(s)", potions_to_use)
             return True
             
         return False
 
-    # Mana potion functionality commented out - WIP
-    # def use_mana_potion(self):
-    #     """Function to increase mana when the mana bar decreases - WIP"""
-    #     mana_percent = self.get_mana_percentage()
-    #     print(f"Mana: {mana_percent:.2%}")
-    #
-    #     if mana_percent < self.mana_threshold:
-    #         print("Using mana potion (Key 2)...")
-    #         self.press_key(self.mana_potion_key)
-    #         time.sleep(1)  # Wait for potion to take effect
-    #         return True
-    #     return False
+    def use_mana_potion(self, frame):
+        """Function to increase mana when the mana bar decreases; True if a potion was queued"""
+        mana_percent = self.get_mana_percentage(frame)
+        self.last_mana_percent = mana_percent
+        if mana_percent is None:
+            return False
+        self.log.info("Mana: {:.2%}", mana_percent, every=self.status_interval)
+
+        if mana_percent >= self.mana_threshold or time.monotonic() < self.mana_ready_time:
+            return False
+        if self._potion_keys_blocked():
+            return False
+        self.log.info("Using mana potion (Key {})...", self.mana_potion_key)
+        self.press_key(self.mana_potion_key, priority=InputDispatcher.PRIORITY_MANA, tag="mana")
+        self.potion_counts["mana"] += 1
+        # Let the potion take effect before the next one, without blocking detection
+        self.mana_ready_time = time.monotonic() + self.mana_potion_delay
+        return True
 
     def use_skill(self, skill_key=None):
         """Function to use skills on entities"""
         if skill_key is None:
             skill_key = self.skill_keys[0]  # Default to first skill
 
-        print(f"Using skill: {skill_key}")
-        self.press_key(skill_key)
+        self.log.info("Using skill: {}", skill_key)
+        self.press_key(skill_key, priority=InputDispatcher.PRIORITY_SKILL, tag="skill")
+
+    def _run_skill_rotation(self):
+        """Queue the next skill of the rotation when its cooldowns allow"""
+        if not self.skills_enabled:
+            return
+        skill = self.skill_rotation.update(time.monotonic())
+        if skill is not None and self.debug_mode:
+            self.log.debug("Rotation queued skill {} (next in {:.1f}s)", skill.key, skill.cooldown)
 
     # Setup regions functionality commented out - using pre-captured images instead
     # def setup_regions(self):
@@ -660,14 +1067,151 @@ class GameAutomation:
     #     """Calibrate color ranges for better detection - not needed with templates"""
     #     print("Using template matching - no color calibration needed")
 
+    def _automation_tick(self, now):
+        """Run the detectors of the current life state; returns the scheduler state for the next delay"""
+        previous = self.life.state
+        state = self.life.advance(now)
+        if previous == LifeStateMachine.REVIVING and state == LifeStateMachine.ALIVE:
+            self.log.info("✅ Post-respawn healing completed - resuming normal monitoring")
+        if state == LifeStateMachine.REVIVING:
+            return self._reviving_tick(now)
+        if state != LifeStateMachine.ALIVE:
+            return self._dead_tick(now)
+
+        # One capture per tick (just the health ROI once locked), shared by every detector below
+        frame = self.capture_tick_frame()
+
+        # Check and use health potion if needed
+        if self.debug_mode:
+            self.log.debug("Calling use_health_potion()...")
+        self.last_health_percent = None
+        potion_result = self.use_health_potion(frame=frame)
+        self._record_tick(frame, potion_result)
+
+        # Handle empty health bar detection
+        if potion_result == "empty":
+            self._on_death(now)
+            return AdaptivePollingScheduler.DEAD
+
+        if self.debug_mode:
+            if potion_result:
+                self.log.debug("Health potion was used")
+            else:
+                self.log.debug("No health potion needed")
+
+        # Mana bar is part of the same tick frame
+        self.use_mana_potion(frame)
+        self._run_skill_rotation()
+
+        self._run_extra_detectors()
+
+        return AdaptivePollingScheduler.COMBAT if potion_result else AdaptivePollingScheduler.ALIVE
+
+    def _on_death(self, now):
+        """ALIVE -> DEAD: drop queued inputs and start the respawn wait"""
+        self.log.info("💀 Character death detected!")
+        # Potions still queued would be wasted on a dead character
+        self.input.cancel("health")
+        self.potions_in_flight = 0
+        self.input.cancel("mana")
+        self.skill_rotation.cancel()
+        self.respawn_gate.reset()  # The button shows up now; never reuse a result from before
+        if self.recorder is not None:
+            self.recorder.dump("death")
+
+        # Check immediately for respawn button (it is outside the health ROI)
+        button_found, _ = self.detect_respawn_button()
+        self.life.died(now, button_visible=button_found)
+        if button_found:
+            self.log.info("🔄 Respawn button available immediately!")
+        else:
+            self.log.info("⏳ Starting respawn wait timer ({}s)", self.life.respawn_wait)
+
+    def _dead_tick(self, now):
+        """DEAD/RESPAWN: no health matching, only respawn button polls and the occasional health probe"""
+        if self.life.probe_due(now):
+            empty, _ = self._read_health(self.capture_tick_frame())
+            self.life.probed(now, revived=not empty)
+            if not empty:
+                self.log.info("✅ Health restored! Character has been revived - resuming normal automation...")
+                self._resume_alive()
+                return AdaptivePollingScheduler.ALIVE
+
+        if self.life.state == LifeStateMachine.RESPAWN and self.life.due(now):
+            if self.click_respawn_button():
+                self.log.info("🎯 Respawn button clicked! Starting post-respawn healing...")
+                self.life.respawned(now)
+                self._resume_alive()
+                return AdaptivePollingScheduler.RESPAWNING
+            self.life.button_missing(now)
+            if self.debug_mode:
+                self.log.debug("Respawn button not found, checking again in {}s", self.life.poll_interval)
+        elif self.debug_mode and self.life.state == LifeStateMachine.DEAD:
+            self.log.debug("Waiting for respawn timeout: {:.1f}s to next check", self.life.time_to_event(now))
+        return AdaptivePollingScheduler.DEAD
+
+    def _reviving_tick(self, now):
+        """REVIVING: forced heals until the post-respawn phase is over"""
+        self.log.info("🩹 Post-respawn healing phase ({:.1f}s/{}s)", self.life.elapsed(now), self.life.heal_duration)
+        self.use_health_potion(force_heal=True)
+        return AdaptivePollingScheduler.RESPAWNING
+
+    def _resume_alive(self):
+        """Fresh health trend and skill cooldowns after a respawn or revival"""
+        self.empty_health_count = 0
+        self.last_empty_health_message = 0
+        self.scheduler.clear()
+        self.health_trend.clear()
+        self.skill_rotation.reset(time.monotonic())
+
+    def _run_extra_detectors(self):
+        """Check the config-declared detectors that are due and queue their actions"""
+        now = time.monotonic()
+        for detector in self.extra_detectors:
+            if not detector.due(now):
+                continue
+            detector.next_check = now + detector.interval
+            try:
+                frame = self.capture_frame(detector.region)
+                found, position = detector.detect(frame, self.pyramid_matcher, self.template_store, self.ui_scale)
+            except Exception as e:
+                self.log.error("Detector '{}' failed: {}", detector.name, e)
+                continue
+            if not found:
+                continue
+            if self.debug_mode:
+                self.log.debug("Detector '{}' matched at {}", detector.name, position)
+            if detector.click:
+                self.click(position, tag=detector.name)
+            if detector.key:
+                self.press_key(detector.key, tag=detector.name)
+
+    def _record_tick(self, frame, potion_result):
+        """Keep the health ROI crop and detector outputs of this tick in the recorder"""
+        if self.recorder is None or not self.health_roi.locked:
+            return
+        with self.metrics.timer("record"):
+            crop = self._health_search_frame(frame)
+            self.recorder.record(
+                crop.raw[:, :, :3],
+                frame.timestamp,
+                health=self.last_health_percent,
+                empty=potion_result == "empty",
+                state="empty" if potion_result == "empty" else ("potion" if potion_result else "ok"),
+                origin=crop.origin,
+            )
+
     def run_automation(self):
         """Main automation loop with respawn system"""
-        print("Starting automation... Press 'q' to quit")
-        print("Health monitoring active (Key 1 for health potions)")
-        print("Respawn system active - will auto-respawn when dead")
-        print("Mana functionality is WIP - coming soon!")
-        print(f"DEBUG: Templates loaded: {list(self.health_templates.keys())}")
-        print("DEBUG: Starting main automation loop...")
+        self.log.info("Starting automation... Press 'q' to quit")
+        self.log.info("Health monitoring active (Key {} for health potions)", self.health_potion_key)
+        self.log.info("Respawn system active - will auto-respawn when dead")
+        if self.mana_estimator is not None:
+            self.log.info("Mana monitoring active (Key {} for mana potions)", self.mana_potion_key)
+        if self.skills_enabled:
+            self.log.info("Skill rotation active: {}", ', '.join(skill.key for skill in self.skill_rotation.skills))
+        self.log.debug("Templates loaded: {}", list(self.health_templates.keys()))
+        self.log.debug("Starting main automation loop...")
 
         # Set up keyboard listener for quit key
         self.automation_running = True
@@ -675,117 +1219,145 @@ class GameAutomation:
         def on_key_press(key):
             try:
                 if hasattr(key, 'char') and key.char == 'q':
-                    print("Stopping automation...")
+                    self.log.info("Stopping automation...")
                     self.automation_running = False
                     return False  # Stop listener
+                if hasattr(key, 'char') and key.char == 'd' and self.recorder is not None:
+                    self.recorder.dump("hotkey")
             except AttributeError:
                 pass
         
-        # Start keyboard listener in background
-        listener = pynput_keyboard.Listener(on_press=on_key_press)
-        listener.start()
+        # Keyboard listener in background, started after the first tick so importing pynput
+        # does not delay the first health reading
+        listener = None
 
         loop_count = 0
+        if self.pipelined:
+            self.pipeline = PipelinedRuntime(self)
+            self.pipeline.start()
         try:
+            self.start_session()
+
             while self.automation_running:
                 loop_count += 1
                 if self.debug_mode:
-                    print(f"\nDEBUG: Automation loop #{loop_count}")
-
-                current_time = time.time()
-
-                # Handle post-respawn healing phase
-                if self.post_respawn_heal_time is not None:
-                    elapsed_heal_time = current_time - self.post_respawn_heal_time
-                    if elapsed_heal_time < self.post_respawn_heal_duration:
-                        print(f"🩹 Post-respawn healing phase ({elapsed_heal_time:.1f}s/{self.post_respawn_heal_duration}s)")
-                        self.use_health_potion(force_heal=True)
-                        time.sleep(1.0)
-                        continue
-                    else:
-                        print("✅ Post-respawn healing completed - resuming normal monitoring")
-                        self.post_respawn_heal_time = None
-
-                # Handle respawn waiting phase
-                if self.respawn_wait_start is not None:
-                    elapsed_wait_time = current_time - self.respawn_wait_start
-                    if elapsed_wait_time < self.respawn_wait_duration:
-                        remaining_time = self.respawn_wait_duration - elapsed_wait_time
-                        print(f"⏳ Waiting for respawn timeout: {remaining_time:.1f}s remaining")
-                        time.sleep(1.0)
-                        continue
-                    else:
-                        # Try to click respawn button
-                        if self.click_respawn_button():
-                            print("🎯 Respawn button clicked! Starting post-respawn healing...")
-                            self.respawn_wait_start = None
-                            self.is_dead = False
-                            self.empty_health_detected = False
-                            self.post_respawn_heal_time = current_time
-                            continue
-                        else:
-                            print("❌ Respawn button not found, extending wait...")
-                            self.respawn_wait_start = current_time  # Reset wait timer
-                            continue
-
-                # Check and use health potion if needed
-                if self.debug_mode:
-                    print("DEBUG: Calling use_health_potion()...")
-                potion_result = self.use_health_potion()
-
-                # Handle empty health bar detection
-                if potion_result == "empty":
-                    if not self.is_dead:
-                        print("💀 Character death detected!")
-                        self.is_dead = True
-                        self.empty_health_detected = True
-                        
-                        # Check immediately for respawn button
-                        button_found, _ = self.detect_respawn_button()
-                        if button_found:
-                            print("🔄 Respawn button available immediately!")
-                            self.respawn_wait_start = current_time - self.respawn_wait_duration  # Skip wait
-                        else:
-                            print(f"⏳ Starting respawn wait timer ({self.respawn_wait_duration}s)")
-                            self.respawn_wait_start = current_time
-                    
-                    # Continue to next iteration to handle respawn logic
-                    time.sleep(1.0)
-                    continue
-                    
-                elif self.empty_health_detected and potion_result != "empty":
-                    # Health has been restored, resume normal operation
-                    print("✅ Health restored! Character has been revived - resuming normal automation...")
-                    self.empty_health_detected = False
-                    self.empty_health_count = 0
-                    self.last_empty_health_message = 0
-                    self.is_dead = False
-                    self.respawn_wait_start = None
-                    self.post_respawn_heal_time = None
-
-                if self.debug_mode:
-                    if potion_result:
-                        print("DEBUG: Health potion was used")
-                    else:
-                        print("DEBUG: No health potion needed")
-
-                # Mana checking commented out - WIP
-                # self.use_mana_potion()
+                    self.log.debug("Automation loop #{}", loop_count)
 
-                # Normal delay for active health monitoring
-                delay_time = 2.0
-                if self.debug_mode:
-                    print(f"DEBUG: Waiting {delay_time} seconds before next check...")
+                _, delay_time = self.step()
+                if listener is None:
+                    listener = start_hotkey_listener(on_key_press)
+                if self.pipeline is not None:
+                    self.pipeline.set_poll_interval(delay_time)
                 time.sleep(delay_time)
 
         except KeyboardInterrupt:
-            print("Automation stopped by user")
+            self.log.info("Automation stopped by user")
         except Exception as e:
-            print(f"ERROR: Automation loop failed: {e}")
+            self.log.error("Automation loop failed: {}", e)
             import traceback
-            traceback.print_exc()
+            self.log.error("{}", traceback.format_exc().rstrip())
         finally:
-            listener.stop()
+            if self.pipeline is not None:
+                self.pipeline.stop()
+                self.pipeline = None
+            self.end_session()
+            if listener is not None:
+                listener.stop()
+
+    def start_session(self, frame=None):
+        """Start the input worker and calibrate the ROIs before the first tick"""
+        self.input.start()
+        # The cached ROIs skip the full-screen search; tuning starts from a fresh one
+        if frame is not None or self.tune_thresholds or not self.restore_calibration():
+            if frame is None:
+                frame = self.capture_frame()
+            self.calibrate_health_roi(frame)
+            self.calibrate_mana_roi(frame)
+            self.save_calibration()
+        self.scheduler.clear()
+        self.health_trend.clear()
+        self.skill_rotation.reset(time.monotonic())
+        self.life.reset()
+        self.potion_counts = dict.fromkeys(self.potion_counts, 0)
+        self.session_started = time.monotonic()
+
+    def step(self):
+        """Run one tick; returns (state, seconds to wait before the next one)"""
+        tick_start = time.monotonic()
+        state = self._automation_tick(tick_start)
+        work_time = time.monotonic() - tick_start
+        self.metrics.record("tick", work_time)
+        self.metrics.maybe_report()
+        if not self.first_reading.is_set() and self.last_health_percent is not None:
+            self._first_health_reading()
+
+        # Poll faster while health is falling, slower while stable; while dead, sleep until
+        # the state machine's next deadline
+        now = time.monotonic()
+        due = self.life.time_to_event(now) if state == AdaptivePollingScheduler.DEAD else None
+        wakes = []
+        if self.skills_enabled and state in (AdaptivePollingScheduler.ALIVE, AdaptivePollingScheduler.COMBAT):
+            # Wake up in time for the next skill instead of waiting out an idle interval
+            wakes.append(self.skill_rotation.next_due(now))
+        if self.healer is not None and self.last_health_percent is not None and now >= self.potion_ready_time:
+            # Read again in time to heal ahead of the predicted threshold crossing
+            # (nothing to decide while the last burst is still cooling down)
+            wakes.append(self.healer.next_check(self.last_health_percent))
+        wakes = [w for w in wakes if w is not None]
+        delay_time = self.scheduler.next_delay(state, work_time, due=due, wake=min(wakes) if wakes else None)
+        if self.debug_mode:
+            self.log.debug("Tick took {:.1f} ms, state '{}', waiting {:.3f}s", work_time * 1000, state, delay_time)
+        return state, delay_time
+
+    def _first_health_reading(self):
+        """Report the launch-to-first-reading time, then load what the first tick did not need"""
+        self.first_reading.set()
+        startup = time.monotonic() - LAUNCH_TIME
+        self.metrics.record("startup", startup)
+        self.log.info("⚡ First health reading ({:.0%}) {:.0f} ms after launch",
+                      self.last_health_percent, startup * 1000)
+        self.input.warm_up()
+
+    def end_session(self):
+        """Stop the input worker, save the calibration and print the final stage timings"""
+        self.input.stop()
+        if self.tune_thresholds:
+            fitted = self.fit_thresholds()
+            if fitted:
+                self.log.info("Tuned thresholds: {}", ", ".join(f"{name}={value:.3f}" for name, value in sorted(fitted.items())))
+                self.tuned_thresholds.update(fitted)
+            else:
+                self.log.info("Not enough detector scores this session to tune thresholds")
+        self.save_calibration()
+        self.log.info("{}", self.metrics.format_summary())
+        self.metrics.close()
+        self.log.flush()
+
+    def status(self):
+        """JSON-ready snapshot for the control endpoint.
+
+        Called from other threads while ticks run: it only reads attributes
+        the tick replaces whole, and percentiles are computed on the caller's
+        thread, so a tick never waits for it.
+        """
+        now = time.monotonic()
+        return {
+            "name": self.name,
+            "profile": self.config.path,
+            "running": self.automation_running,
+            "uptime": None if self.session_started is None else round(now - self.session_started, 3),
+            "state": self.life.state,
+            "state_seconds": round(self.life.elapsed(now), 3),
+            "deaths": self.life.deaths,
+            "respawns": self.life.respawns,
+            "health": self.last_health_percent,
+            "mana": self.last_mana_percent,
+            "potions": dict(self.potion_counts),
+            "ui_scale": self.ui_scale,
+            "health_roi": self.health_roi.region if self.health_roi.locked else None,
+            "thresholds": dict(self.tuned_thresholds),
+            "stages": self.metrics.summary(),
+        }
 
 
 
@@ -795,7 +1367,37 @@ def main():
     # Parse command line arguments
     parser = argparse.ArgumentParser(description='Game Automation Script')
     parser.add_argument('--debug', action='store_true', 
-                       help='Enable debug mode (increases CPU usage)')
+                       help='Enable verbose debug diagnostics')
+    parser.add_argument('--config', metavar='PATH',
+                       help='TOML file with detectors, templates, thresholds and keys (default: config.toml)')
+    parser.add_argument('--latency-budget', type=float, default=0.2,
+                       help='Max seconds between a health drop and the reaction (default: 0.2)')
+    parser.add_argument('--cpu-budget', type=float, default=0.25,
+                       help='Max fraction of one core spent on detection (default: 0.25)')
+    parser.add_argument('--metrics-interval', type=float, default=30.0,
+                       help='Seconds between stage timing summaries, 0 to disable (default: 30)')
+    parser.add_argument('--metrics-export', metavar='PATH',
+                       help='Append stage timings to PATH (.csv = raw samples, otherwise JSON lines)')
+    parser.add_argument('--record-seconds', type=float, default=10.0,
+                       help="Seconds of health ROI frames kept for dumps on death or 'd' (0 disables)")
+    parser.add_argument('--match-workers', type=int, default=None,
+                       help='Threads for full-screen template searches (default: one per core, up to 8)')
+    parser.add_argument('--skills', action='store_true', default=None,
+                       help='Run the skill rotation from the config (also skills.enabled)')
+    parser.add_argument('--matcher', choices=MATCHER_BACKENDS, default='auto',
+                       help='Template matching kernel for ROI matches (default: native when built, else OpenCV)')
+    parser.add_argument('--gpu', choices=GPU_BACKENDS, default='off',
+                       help='Run full-screen searches on the GPU via CUDA or OpenCL (default: off)')
+    parser.add_argument('--window', metavar='ID_OR_TITLE',
+                       help='Capture only this window (ID or part of its title), even when covered (also capture.window)')
+    parser.add_argument('--calibrate', action='store_true', default=None,
+                       help='Search the full screen, tune detector thresholds from this session and cache them (also calibration.tune)')
+    parser.add_argument('--serial', action='store_true',
+                       help='Capture and detect on one thread instead of pipelining them')
+    parser.add_argument('--control-port', type=int, default=None,
+                       help='Serve telemetry and start/stop/profile commands on localhost:PORT, 0 disables (also control.port)')
+    parser.add_argument('--fast-start', action='store_true', default=None,
+                       help="Start monitoring at launch from the calibration cache, without waiting for 'r' (also startup.fast)")
     args = parser.parse_args()
     
     debug_mode = args.debug
@@ -806,41 +1408,132 @@ def main():
         print("Starting Game Automation (optimized mode)...")
 
     try:
-        automation = GameAutomation(debug_mode=debug_mode)
+        def create_automation(config):
+            return GameAutomation(
+                debug_mode=debug_mode,
+                latency_budget=args.latency_budget,
+                cpu_budget=args.cpu_budget,
+                pipelined=not args.serial,
+                metrics_interval=args.metrics_interval,
+                metrics_export=args.metrics_export,
+                record_seconds=args.record_seconds,
+                match_workers=args.match_workers,
+                config=config,
+                skills=args.skills,
+                matcher_backend=args.matcher,
+                gpu=args.gpu,
+                window=args.window,
+                calibrate=args.calibrate,
+            )
+
+        automation = create_automation(args.config)
         if debug_mode:
             print("DEBUG: GameAutomation instance created")
         else:
             print("GameAutomation instance created")
 
-
-
-        print("\nGame Automation - Health Monitoring Active")
-        print("=========================================")
-        print("Health bar templates loaded from images folder")
-        print("Key 1: Health Potion")
-        print("Mana functionality: WIP (Work In Progress)")
-        if debug_mode:
-            print("Debug mode: ENABLED (higher CPU usage)")
-        else:
-            print("Debug mode: DISABLED (optimized for lower CPU usage)")
-        print("\nFeatures:")
-        print("- Smart health potion usage based on health level")
-        print("- Empty health detection (stops potions when dead/incapacitated)")
-        print("- Automatic revival detection and resumption")
-        print("\nCommands:")
-        print("- Press 'r' to start/restart automation")
-        print("- Press 'q' to quit")
-
-        if debug_mode:
-            print("DEBUG: Entering main command loop...")
-        print("Press 'r' to start automation, 'q' to quit")
-        
         # Set up global key listener
         automation_started = False
         main_running = True
-        
+        automation_thread = None
+
+        def run_automation_in_background():
+            nonlocal automation_started
+            try:
+                automation.run_automation()
+            finally:
+                automation_started = False
+
+        def start_automation():
+            nonlocal automation_started, automation_thread
+            automation_started = True
+            automation_thread = threading.Thread(
+                target=run_automation_in_background, name="automation", daemon=True
+            )
+            automation_thread.start()
+
+        # Remote start/stop and profile switching (control endpoint); a profile switch
+        # rebuilds the automation from the new config on its own thread
+        control_lock = threading.Lock()
+
+        def remote_start(instance=None):
+            with control_lock:
+                if not automation_started:
+                    start_automation()
+            return {"running": True}
+
+        def remote_stop(instance=None):
+            automation.automation_running = False
+            return {"running": False}
+
+        def switch_profile(profile, instance=None):
+            config = load_config(automation.config.resolve(profile))
+            threading.Thread(target=restart_with_profile, args=(config,), name="profile-switch", daemon=True).start()
+            return {"profile": config.path}
+
+        def restart_with_profile(config):
+            nonlocal automation
+            with control_lock:
+                was_running = automation_started
+                automation.automation_running = False
+                if automation_thread is not None:
+                    automation_thread.join(timeout=5.0)
+                automation.capture.close()
+                automation.match_pool.close()
+                automation = create_automation(config)
+                if was_running:
+                    start_automation()
+            print(f"Switched to profile {config.path}")
+
+        control_config = automation.config["control"]
+        control_port = control_config["port"] if args.control_port is None else args.control_port
+        control = None
+        if control_port:
+            control = ControlServer(
+                lambda: [automation.status()],
+                {"start": remote_start, "stop": remote_stop, "profile": switch_profile},
+                host=control_config["host"],
+                port=control_port,
+                log=automation.log,
+            )
+            control.start()
+
+        fast_start = automation.config["startup"]["fast"] if args.fast_start is None else args.fast_start
+        if fast_start:
+            # Monitoring starts now; the banner and the hotkey listener (pynput import) wait
+            # until health has been read once
+            start_automation()
+            automation.first_reading.wait(timeout=2.0)
+            print("Fast start: monitoring active. Press 'q' to quit, 'r' to restart after stopping")
+        else:
+            print("\nGame Automation - Health Monitoring Active")
+            print("=========================================")
+            print("Health bar templates loaded from images folder")
+            print(f"Key {automation.health_potion_key}: Health Potion")
+            if automation.mana_estimator is not None:
+                print(f"Key {automation.mana_potion_key}: Mana Potion")
+            if debug_mode:
+                print("Debug mode: ENABLED (verbose diagnostics)")
+            else:
+                print("Debug mode: DISABLED")
+            print("\nFeatures:")
+            print("- Smart health potion usage based on health level")
+            print("- Empty health detection (stops potions when dead/incapacitated)")
+            print("- Automatic revival detection and resumption")
+            if automation.mana_estimator is not None:
+                print("- Mana potion usage from the mana bar colour")
+            print("\nCommands:")
+            print("- Press 'r' to start/restart automation")
+            print("- Press 'd' to save the last seconds of frames (recorder)")
+            print("- Press 'q' to quit")
+
+            if debug_mode:
+                print("DEBUG: Entering main command loop...")
+            print("Press 'r' to start automation, 'q' to quit")
+
         def on_global_key_press(key):
-            nonlocal automation_started, main_running
+            # Runs on the listener thread: never block here so hotkeys stay responsive
+            nonlocal main_running
             try:
                 if hasattr(key, 'char'):
                     if key.char == 'r' and not automation_started:
@@ -848,27 +1541,30 @@ def main():
                             print("DEBUG: 'r' key pressed - starting automation")
                         else:
                             print("Starting automation...")
-                        automation_started = True
-                        automation.run_automation()
-                        automation_started = False
+                        start_automation()
                     elif key.char == 'q':
                         if debug_mode:
                             print("DEBUG: 'q' key pressed - quitting")
                         else:
                             print("Quitting...")
+                        automation.automation_running = False
                         main_running = False
                         return False  # Stop listener
             except AttributeError:
                 pass
-        
-        listener = pynput_keyboard.Listener(on_press=on_global_key_press)
-        listener.start()
-        
+
+        listener = start_hotkey_listener(on_global_key_press)
+
         try:
             while main_running:
                 time.sleep(0.1)
         finally:
             listener.stop()
+            if control is not None:
+                control.stop()
+            automation.automation_running = False
+            if automation_thread is not None:
+                automation_thread.join(timeout=5.0)
 
     except Exception as e:
         print(f"CRITICAL ERROR in main(): {e}")
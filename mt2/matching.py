@@ -0,0 +1,411 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Template matchers shared by the detectors.
+"""
+
+import math
+import os
+import threading
+from concurrent.futures import ThreadPoolExecutor
+
+import cv2
+import numpy as np
+
+try:
+    from native import fastmatch  # Optional compiled kernel, see native/setup.py
+except ImportError:
+    fastmatch = None
+
+MATCHER_BACKENDS = ("auto", "opencv", "native")
+GPU_BACKENDS = ("off", "auto", "cuda", "opencl")
+
+# Confidence levels reported by debug diagnostics (the old locateOnScreen sweep)
+DEBUG_CONFIDENCE_LEVELS = (0.9, 0.8, 0.7, 0.6, 0.5)
+
+
+def confidence_levels(result, levels=DEBUG_CONFIDENCE_LEVELS):
+    """{level: number of locations in a correlation map scoring at least level}"""
+    if result is None:
+        return {level: 0 for level in levels}
+    return {level: int(np.count_nonzero(result >= level)) for level in levels}
+
+
+def downscale(image, scale):
+    """Resize an image by `scale` with area interpolation (good for shrinking)"""
+    height, width = image.shape[:2]
+    size = (max(1, int(round(width * scale))), max(1, int(round(height * scale))))
+    return cv2.resize(image, size, interpolation=cv2.INTER_AREA)
+
+
+class NativeKernel:
+    """TM_CCOEFF_NORMED through the compiled fastmatch module, one Matcher per template array.
+
+    Every Matcher keeps its template statistics and scratch buffers between
+    calls; each returned map is its own array, so it can be kept (e.g. for
+    debug reports) and read while other threads match the same template.
+    """
+
+    def __init__(self):
+        self._matchers = {}  # id(template array) -> (template array, fastmatch.Matcher)
+
+    def correlate(self, image, template_gray):
+        entry = self._matchers.get(id(template_gray))
+        if entry is None or entry[0] is not template_gray:
+            entry = (template_gray, fastmatch.Matcher(template_gray))
+            self._matchers[id(template_gray)] = entry
+        return entry[1].match(image)
+
+
+def create_native_kernel(backend="auto", method=cv2.TM_CCOEFF_NORMED):
+    """NativeKernel for `backend`, or None to keep using cv2.matchTemplate"""
+    if backend not in MATCHER_BACKENDS:
+        raise ValueError(f"Unknown matcher backend '{backend}' (choose from {MATCHER_BACKENDS})")
+    if backend == "opencv":
+        return None
+    if fastmatch is None or method != cv2.TM_CCOEFF_NORMED:
+        if backend == "native":
+            print("WARNING: Native matcher not available (build mt2/native), falling back to OpenCV")
+        return None
+    return NativeKernel()
+
+
+class GpuKernel:
+    """Large correlations on the GPU through cv2.cuda, or UMat when only OpenCL is available.
+
+    Templates are uploaded once and stay on the device; the last uploaded
+    image is reused, so every template searched in one frame shares a
+    single upload. Only the correlation map comes back to the host.
+    """
+
+    def __init__(self, kind, method=cv2.TM_CCOEFF_NORMED):
+        self.kind = kind  # "cuda" or "opencl"
+        self.method = method
+        self._templates = {}  # id(template array) -> (template array, device copy)
+        self._image = (None, None)  # (host image, device copy) of the last upload
+        self._lock = threading.Lock()  # One device stream, shared by pool threads
+        if kind == "cuda":
+            self._matcher = cv2.cuda.createTemplateMatching(cv2.CV_8UC1, method)
+        else:
+            cv2.ocl.setUseOpenCL(True)
+
+    def _upload(self, array):
+        if self.kind == "cuda":
+            device = cv2.cuda_GpuMat()
+            device.upload(np.ascontiguousarray(array))
+            return device
+        return cv2.UMat(np.ascontiguousarray(array))
+
+    def correlate(self, image, template_gray):
+        with self._lock:
+            if self._image[0] is not image:
+                self._image = (image, self._upload(image))
+            entry = self._templates.get(id(template_gray))
+            if entry is None or entry[0] is not template_gray:
+                entry = (template_gray, self._upload(template_gray))
+                self._templates[id(template_gray)] = entry
+
+            if self.kind == "cuda":
+                return self._matcher.match(self._image[1], entry[1]).download()
+            return cv2.matchTemplate(self._image[1], entry[1], self.method).get()
+
+
+def create_gpu_kernel(backend="off", method=cv2.TM_CCOEFF_NORMED):
+    """GpuKernel for `backend`, or None to stay on the CPU"""
+    if backend not in GPU_BACKENDS:
+        raise ValueError(f"Unknown GPU backend '{backend}' (choose from {GPU_BACKENDS})")
+    if backend == "off":
+        return None
+    if backend in ("auto", "cuda"):
+        try:
+            if cv2.cuda.getCudaEnabledDeviceCount() > 0:
+                return GpuKernel("cuda", method)
+        except (AttributeError, cv2.error):
+            pass
+        if backend == "cuda":
+            print("WARNING: No CUDA device or OpenCV built without CUDA, falling back to the CPU")
+            return None
+    if cv2.ocl.haveOpenCL():
+        return GpuKernel("opencl", method)
+    print("WARNING: No OpenCL device available, falling back to the CPU")
+    return None
+
+
+class MatchPool:
+    """Thread pool for independent matches; cv2.matchTemplate releases the GIL.
+
+    Work submitted from inside a pool task runs inline instead, so nested
+    parallel calls never wait on their own workers.
+    """
+
+    def __init__(self, workers=None):
+        if workers is None:
+            workers = min(8, os.cpu_count() or 1)
+        self.workers = max(1, int(workers))
+        self._executor = None
+        if self.workers > 1:
+            self._executor = ThreadPoolExecutor(max_workers=self.workers, thread_name_prefix="match")
+        self._local = threading.local()
+
+    @property
+    def parallel(self):
+        """True when work would actually be spread over several threads"""
+        return self._executor is not None and not getattr(self._local, "inside", False)
+
+    def _run(self, function, item):
+        self._local.inside = True
+        try:
+            return function(item)
+        finally:
+            self._local.inside = False
+
+    def map(self, function, items):
+        """[function(item) for item in items], in parallel when possible"""
+        items = list(items)
+        if not self.parallel or len(items) < 2:
+            return [function(item) for item in items]
+        return list(self._executor.map(lambda item: self._run(function, item), items))
+
+    def correlate(self, image, template, method):
+        """cv2.matchTemplate split into horizontal bands, one per worker; same result as one call"""
+        th = template.shape[0]
+        rows = image.shape[0] - th + 1
+        bands = min(self.workers, rows)
+        if not self.parallel or bands < 2:
+            return cv2.matchTemplate(image, template, method)
+
+        result = np.empty((rows, image.shape[1] - template.shape[1] + 1), dtype=np.float32)
+        edges = np.linspace(0, rows, bands + 1).astype(int)
+
+        def band(index):
+            y0, y1 = edges[index], edges[index + 1]
+            result[y0:y1] = cv2.matchTemplate(image[y0:y1 + th - 1], template, method)
+
+        self.map(band, range(bands))
+        return result
+
+    def close(self):
+        if self._executor is not None:
+            self._executor.shutdown(wait=False)
+            self._executor = None
+
+
+class PyramidMatcher:
+    """Coarse-to-fine template matcher.
+
+    The template is first matched on a downscaled copy of the image. Only small
+    windows around the best `candidates` coarse peaks are then matched at full
+    resolution. Templates that would become too small at the coarse scale are
+    matched at full resolution directly.
+    """
+
+    def __init__(self, scale=0.5, candidates=3, refine_margin=4, min_template_size=6,
+                 method=cv2.TM_CCOEFF_NORMED, metrics=None, pool=None, parallel_min_pixels=250_000,
+                 backend="auto", gpu="off"):
+        self.scale = scale
+        self.candidates = candidates
+        self.refine_margin = refine_margin  # Extra full-resolution pixels around each candidate
+        self.min_template_size = min_template_size  # Smallest coarse template side still trusted
+        self.method = method
+        self.metrics = metrics  # Optional StageMetrics, records one "match_<template>" stage per call
+        # {template name: (image, map)} of whole-image full-resolution matches when set to a dict
+        # (debug diagnostics); refine windows are not kept
+        self.full_results = None
+        self.pool = pool  # Optional MatchPool, splits large correlations across cores
+        self.parallel_min_pixels = parallel_min_pixels  # Smaller images are not worth splitting
+        # Native kernel for small (ROI) images; large ones stay on OpenCV's FFT path
+        self.native = create_native_kernel(backend, method)
+        # Optional GPU for the large (full-screen, coarse) correlations
+        self.gpu = create_gpu_kernel(gpu, method)
+
+    @property
+    def backend(self):
+        name = "native" if self.native is not None else "opencv"
+        return f"{name}+{self.gpu.kind}" if self.gpu is not None else name
+
+    def _correlate(self, image, template_gray):
+        if image.size >= self.parallel_min_pixels:
+            if self.gpu is not None:
+                return self.gpu.correlate(image, template_gray)
+            if self.pool is not None:
+                return self.pool.correlate(image, template_gray, self.method)
+        elif self.native is not None:
+            return self.native.correlate(image, template_gray)
+        return cv2.matchTemplate(image, template_gray, self.method)
+
+    def can_downscale(self, template):
+        if self.scale >= 1.0:
+            return False
+        return min(template.width, template.height) * self.scale >= self.min_template_size
+
+    def match_full(self, image, template_gray, name=None):
+        """Plain full-resolution match; returns (score, (x, y))"""
+        if image.shape[0] < template_gray.shape[0] or image.shape[1] < template_gray.shape[1]:
+            return 0.0, None
+        result = self._correlate(image, template_gray)
+        if name is not None and self.full_results is not None:
+            self.full_results[name] = (image, result)
+        _, max_val, _, max_loc = cv2.minMaxLoc(result)
+        return float(max_val), max_loc
+
+    def full_result(self, image, template):
+        """Full-resolution correlation map of `template` on `image`, reusing the one kept by the last match"""
+        kept = self.full_results.get(template.name) if self.full_results is not None else None
+        if kept is not None and kept[0] is image:
+            return kept[1]
+        if image.shape[0] < template.gray.shape[0] or image.shape[1] < template.gray.shape[1]:
+            return None
+        result = self._correlate(image, template.gray)
+        if self.full_results is not None:
+            self.full_results[template.name] = (image, result)
+        return result
+
+    def match(self, image, template, coarse=None, coarse_result=None):
+        """Find `template` (a templates.Template) in grayscale `image`; returns (score, (x, y)).
+
+        `coarse` may be a precomputed downscaled copy of `image` at `self.scale`,
+        so several templates searched in the same frame share one resize.
+        `coarse_result` may be the map from coarse_result() for the same pair.
+        """
+        if self.metrics is None:
+            return self._match(image, template, coarse, coarse_result)
+        with self.metrics.timer(f"match_{template.name}"):
+            return self._match(image, template, coarse, coarse_result)
+
+    def coarse_result(self, coarse, template):
+        """Correlation map of `template` on the downscaled image, None if it cannot be matched there"""
+        if not self.can_downscale(template):
+            return None
+        coarse_template = template.scaled(self.scale)
+        if coarse.shape[0] < coarse_template.shape[0] or coarse.shape[1] < coarse_template.shape[1]:
+            return None
+        return self._correlate(coarse, coarse_template)
+
+    def time_full(self, image, template):
+        """match_full on a Template, recorded under its "match_<template>" stage"""
+        if self.metrics is None:
+            return self.match_full(image, template.gray, template.name)
+        with self.metrics.timer(f"match_{template.name}"):
+            return self.match_full(image, template.gray, template.name)
+
+    def _match(self, image, template, coarse, result):
+        if not self.can_downscale(template):
+            return self.match_full(image, template.gray, template.name)
+
+        if result is None:
+            if coarse is None:
+                coarse = downscale(image, self.scale)
+            result = self.coarse_result(coarse, template)
+            if result is None:
+                return self.match_full(image, template.gray, template.name)
+
+        best_score, best_loc = 0.0, None
+        for cx, cy in self._peaks(result, template.scaled(self.scale).shape):
+            score, loc = self._refine(image, template.gray, cx, cy)
+            if loc is not None and score > best_score:
+                best_score, best_loc = score, loc
+        return best_score, best_loc
+
+    def _peaks(self, result, template_shape):
+        """Top coarse peaks with non-maximum suppression of one template size"""
+        th, tw = template_shape[:2]
+        peaks = []
+        for _ in range(self.candidates):
+            _, max_val, _, (x, y) = cv2.minMaxLoc(result)
+            if not np.isfinite(max_val) or max_val <= -1.0:
+                break
+            peaks.append((x, y))
+            result[max(0, y - th // 2): y + th // 2 + 1, max(0, x - tw // 2): x + tw // 2 + 1] = -1.0
+        return peaks
+
+    def _refine(self, image, template_gray, cx, cy):
+        """Full-resolution match in a small window around a coarse peak"""
+        th, tw = template_gray.shape[:2]
+        margin = self.refine_margin + int(math.ceil(1.0 / self.scale))
+        x = int(round(cx / self.scale))
+        y = int(round(cy / self.scale))
+        x0 = max(0, x - margin)
+        y0 = max(0, y - margin)
+        x1 = min(image.shape[1], x + tw + margin)
+        y1 = min(image.shape[0], y + th + margin)
+        score, loc = self.match_full(image[y0:y1, x0:x1], template_gray)
+        if loc is None:
+            return 0.0, None
+        return score, (loc[0] + x0, loc[1] + y0)
+
+
+class TemplateCascade:
+    """Early-exit matcher over templates ordered by likelihood.
+
+    Templates are tried in the given order and the search stops at the first
+    one scoring at least `accept`. When a coarse image is available every
+    template is scored there first; one whose coarse peak (plus
+    `prune_margin`, since downscaling blurs the peak) cannot reach `reject`
+    or the best full-resolution score so far is skipped.
+    """
+
+    def __init__(self, matcher, accept=0.85, reject=0.3, prune_margin=0.1):
+        self.matcher = matcher  # PyramidMatcher doing the actual correlations
+        self.accept = accept
+        self.reject = reject
+        self.prune_margin = prune_margin
+        self.pruned = 0  # Templates skipped on their coarse bound
+        self.stopped_early = 0  # Searches that ended on an accepted template
+
+    def match(self, image, templates, coarse=None, pyramid=False):
+        """Returns (template, score, location, {template name: score}) of the best match.
+
+        `pyramid` matches coarse-to-fine (large searches), otherwise templates
+        are matched at full resolution. `coarse` enables pruning. Pyramid
+        searches run every template at once when the matcher has a parallel pool.
+        """
+        pool = self.matcher.pool
+        if pyramid and pool is not None and pool.parallel:
+            return self._match_parallel(image, templates, coarse, pool)
+
+        best_template, best_score, best_loc = None, 0.0, None
+        scores = {}
+        for template in templates:
+            coarse_result = None
+            if coarse is not None:
+                coarse_result = self.matcher.coarse_result(coarse, template)
+                if coarse_result is not None:
+                    bound = float(coarse_result.max()) + self.prune_margin
+                    if bound < max(self.reject, best_score):
+                        self.pruned += 1
+                        continue
+
+            if pyramid:
+                score, loc = self.matcher.match(image, template, coarse, coarse_result)
+            else:
+                score, loc = self.matcher.time_full(image, template)
+            scores[template.name] = score
+
+            if loc is not None and score > best_score:
+                best_template, best_score, best_loc = template, score, loc
+            if best_score >= self.accept:
+                self.stopped_early += 1
+                break
+        return best_template, best_score, best_loc, scores
+
+    def _match_parallel(self, image, templates, coarse, pool):
+        """All templates on the pool; with every worker busy an early exit would save nothing"""
+
+        def evaluate(template):
+            coarse_result = None
+            if coarse is not None:
+                coarse_result = self.matcher.coarse_result(coarse, template)
+                if coarse_result is not None and float(coarse_result.max()) + self.prune_margin < self.reject:
+                    return template, None, None
+            return (template,) + self.matcher.match(image, template, coarse, coarse_result)
+
+        best_template, best_score, best_loc = None, 0.0, None
+        scores = {}
+        for template, score, loc in pool.map(evaluate, templates):
+            if score is None:
+                self.pruned += 1
+                continue
+            scores[template.name] = score
+            if loc is not None and score > best_score:
+                best_template, best_score, best_loc = template, score, loc
+        return best_template, best_score, best_loc, scores
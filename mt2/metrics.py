@@ -0,0 +1,178 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Always-on latency instrumentation.
+Every loop stage records its duration into a fixed-size rolling window.
+Recording is a lock plus an array store, percentiles are only computed when
+the periodic summary is printed or exported.
+"""
+
+import csv
+import json
+import threading
+import time
+
+import numpy as np
+
+
+class RollingHistogram:
+    """Latest `size` samples of one stage, in seconds"""
+
+    def __init__(self, size=2048):
+        self._values = np.zeros(size, dtype=np.float64)
+        self._index = 0
+        self._filled = 0
+        self.count = 0  # Lifetime number of samples
+
+    def record(self, value):
+        self._values[self._index] = value
+        self._index = (self._index + 1) % self._values.size
+        if self._filled < self._values.size:
+            self._filled += 1
+        self.count += 1
+
+    def percentiles(self, quantiles=(50, 95, 99)):
+        if self._filled == 0:
+            return None
+        return np.percentile(self._values[: self._filled], quantiles)
+
+    def max(self):
+        return float(self._values[: self._filled].max()) if self._filled else 0.0
+
+
+class _StageTimer:
+    """Context manager recording the wall time of a block into a stage"""
+
+    __slots__ = ("_metrics", "_stage", "_start")
+
+    def __init__(self, metrics, stage):
+        self._metrics = metrics
+        self._stage = stage
+
+    def __enter__(self):
+        self._start = time.perf_counter()
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        self._metrics.record(self._stage, time.perf_counter() - self._start)
+        return False
+
+
+class StageMetrics:
+    """Per-stage rolling latency histograms with a periodic summary and optional export.
+
+    `export_path` ending in .csv receives every raw sample (timestamp, stage, ms),
+    any other path receives one JSON summary object per line and interval.
+    CSV rows are also flushed whenever `flush_rows` are pending, so they stay
+    bounded with the summary disabled.
+    With a `log`, the periodic summary and export happen on its writer thread.
+    """
+
+    def __init__(self, window=2048, summary_interval=30.0, export_path=None, enabled=True, log=None,
+                 flush_rows=4096):
+        self.window = window
+        self.summary_interval = summary_interval
+        self.export_path = export_path
+        self.enabled = enabled
+        self.log = log
+        self._stages = {}
+        self._lock = threading.Lock()
+        self._last_report = time.monotonic()
+        self._pending_rows = []  # Raw samples waiting for the next CSV flush
+        self.flush_rows = flush_rows
+        self._flush_queued = False
+        self._export_csv = bool(export_path) and export_path.lower().endswith(".csv")
+
+    def timer(self, stage):
+        """`with metrics.timer("capture"): ...` records the block's duration"""
+        return _StageTimer(self, stage)
+
+    def record(self, stage, seconds):
+        if not self.enabled:
+            return
+        with self._lock:
+            histogram = self._stages.get(stage)
+            if histogram is None:
+                histogram = RollingHistogram(self.window)
+                self._stages[stage] = histogram
+            histogram.record(seconds)
+            if not self._export_csv:
+                return
+            self._pending_rows.append((time.time(), stage, seconds * 1000.0))
+            if len(self._pending_rows) < self.flush_rows or self._flush_queued:
+                return
+            self._flush_queued = True
+        if self.log is not None:
+            self.log.defer(self.export)
+        else:
+            self.export()
+
+    def summary(self):
+        """{stage: {"count", "p50_ms", "p95_ms", "p99_ms", "max_ms"}}"""
+        with self._lock:
+            stages = list(self._stages.items())
+        result = {}
+        for stage, histogram in stages:
+            values = histogram.percentiles()
+            if values is None:
+                continue
+            result[stage] = {
+                "count": histogram.count,
+                "p50_ms": round(float(values[0]) * 1000.0, 3),
+                "p95_ms": round(float(values[1]) * 1000.0, 3),
+                "p99_ms": round(float(values[2]) * 1000.0, 3),
+                "max_ms": round(histogram.max() * 1000.0, 3),
+            }
+        return result
+
+    def format_summary(self, summary=None):
+        summary = self.summary() if summary is None else summary
+        parts = [
+            f"{stage} {s['p50_ms']:.1f}/{s['p95_ms']:.1f}/{s['p99_ms']:.1f}"
+            for stage, s in sorted(summary.items())
+        ]
+        return "📊 Stage timings ms p50/p95/p99: " + (" | ".join(parts) if parts else "no samples")
+
+    def maybe_report(self, now=None):
+        """Print (and export) the summary once every `summary_interval` seconds"""
+        if not self.enabled or self.summary_interval <= 0:
+            return False
+        now = time.monotonic() if now is None else now
+        if now - self._last_report < self.summary_interval:
+            return False
+        self._last_report = now
+        summary = self.summary()
+        if self.log is not None:
+            self.log.info("{}", self.format_summary(summary))
+            self.log.defer(self.export, summary)
+        else:
+            print(self.format_summary(summary))
+            self.export(summary)
+        return True
+
+    def export(self, summary=None):
+        if not self.export_path:
+            return
+        try:
+            if self._export_csv:
+                with self._lock:
+                    rows, self._pending_rows = self._pending_rows, []
+                    self._flush_queued = False
+                with open(self.export_path, "a", newline="") as f:
+                    writer = csv.writer(f)
+                    if f.tell() == 0:
+                        writer.writerow(["timestamp", "stage", "ms"])
+                    writer.writerows(rows)
+            else:
+                summary = self.summary() if summary is None else summary
+                with open(self.export_path, "a") as f:
+                    f.write(json.dumps({"timestamp": time.time(), "stages": summary}) + "\n")
+        except OSError as e:
+            if self.log is not None:
+                self.log.warning("Could not export metrics to {}: {}", self.export_path, e)
+            else:
+                print(f"WARNING: Could not export metrics to {self.export_path}: {e}")
+
+    def close(self):
+        """Flush whatever has not been exported yet"""
+        self.export()
@@ -0,0 +1,169 @@
+// LICENSE: BSD 3-Clause License
+// Author:Cyber-syntax
+// Native normalised cross-correlation (cv2.TM_CCOEFF_NORMED) for small ROI matches.
+// Template statistics are computed once per Matcher, window sums come from
+// integral images, the dot products are SIMD-vectorised and the scratch buffers
+// are kept between calls, so a steady-state match only allocates the map it returns.
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace {
+
+class Matcher {
+public:
+    explicit Matcher(py::array_t<std::uint8_t, py::array::c_style | py::array::forcecast> templ) {
+        if (templ.ndim() != 2) {
+            throw std::invalid_argument("template must be a 2D grayscale array");
+        }
+        height_ = static_cast<int>(templ.shape(0));
+        width_ = static_cast<int>(templ.shape(1));
+        if (height_ == 0 || width_ == 0) {
+            throw std::invalid_argument("template must not be empty");
+        }
+
+        // Zero-mean template: sum(T' * I) equals sum(T' * (I - mean(I))), so the
+        // window mean never has to be subtracted from the image
+        const std::uint8_t* data = templ.data();
+        const std::size_t count = static_cast<std::size_t>(width_) * height_;
+        double sum = 0.0;
+        for (std::size_t i = 0; i < count; ++i) {
+            sum += data[i];
+        }
+        const double mean = sum / static_cast<double>(count);
+        zero_mean_.resize(count);
+        double norm2 = 0.0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const double value = data[i] - mean;
+            zero_mean_[i] = static_cast<float>(value);
+            norm2 += value * value;
+        }
+        norm_ = std::sqrt(norm2);
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Correlation map of the template over `image`, in a new array owned by the
+    // caller: it stays valid however the matcher is used afterwards
+    py::array_t<float> match(py::array_t<std::uint8_t, py::array::c_style | py::array::forcecast> image) {
+        if (image.ndim() != 2) {
+            throw std::invalid_argument("image must be a 2D grayscale array");
+        }
+        const int rows = static_cast<int>(image.shape(0));
+        const int cols = static_cast<int>(image.shape(1));
+        if (rows < height_ || cols < width_) {
+            throw std::invalid_argument("image is smaller than the template");
+        }
+        const int out_rows = rows - height_ + 1;
+        const int out_cols = cols - width_ + 1;
+
+        py::array_t<float> result({out_rows, out_cols});
+        float* out = result.mutable_data();
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex_);
+            correlate(image.data(), rows, cols, out_rows, out_cols, out);
+        }
+        return result;
+    }
+
+private:
+    void correlate(const std::uint8_t* image, int rows, int cols, int out_rows, int out_cols, float* out) {
+        const std::size_t pixels = static_cast<std::size_t>(rows) * cols;
+        pixels_.resize(pixels);
+        for (std::size_t i = 0; i < pixels; ++i) {
+            pixels_[i] = image[i];
+        }
+
+        // Integral images of I and I^2, one extra row and column of zeros
+        const int stride = cols + 1;
+        sums_.assign(static_cast<std::size_t>(rows + 1) * stride, 0.0);
+        squares_.assign(static_cast<std::size_t>(rows + 1) * stride, 0.0);
+        for (int y = 0; y < rows; ++y) {
+            double row_sum = 0.0;
+            double row_square = 0.0;
+            const std::uint8_t* line = image + static_cast<std::size_t>(y) * cols;
+            for (int x = 0; x < cols; ++x) {
+                row_sum += line[x];
+                row_square += static_cast<double>(line[x]) * line[x];
+                const std::size_t at = static_cast<std::size_t>(y + 1) * stride + x + 1;
+                sums_[at] = sums_[at - stride] + row_sum;
+                squares_[at] = squares_[at - stride] + row_square;
+            }
+        }
+
+        const double count = static_cast<double>(width_) * height_;
+        for (int y = 0; y < out_rows; ++y) {
+            for (int x = 0; x < out_cols; ++x) {
+                const double numerator = dot(x, y, cols);
+                const double window_sum = window(sums_, x, y, stride);
+                const double window_square = window(squares_, x, y, stride);
+                const double variance = std::max(0.0, window_square - window_sum * window_sum / count);
+                out[static_cast<std::size_t>(y) * out_cols + x] =
+                    static_cast<float>(normalise(numerator, std::sqrt(variance) * norm_));
+            }
+        }
+    }
+
+    double dot(int x, int y, int cols) const {
+        float total = 0.0f;
+        for (int row = 0; row < height_; ++row) {
+            const float* t = zero_mean_.data() + static_cast<std::size_t>(row) * width_;
+            const float* p = pixels_.data() + static_cast<std::size_t>(y + row) * cols + x;
+            float acc = 0.0f;
+#pragma omp simd reduction(+ : acc)
+            for (int col = 0; col < width_; ++col) {
+                acc += t[col] * p[col];
+            }
+            total += acc;
+        }
+        return total;
+    }
+
+    double window(const std::vector<double>& table, int x, int y, int stride) const {
+        const std::size_t top = static_cast<std::size_t>(y) * stride;
+        const std::size_t bottom = static_cast<std::size_t>(y + height_) * stride;
+        return table[bottom + x + width_] - table[bottom + x] - table[top + x + width_] + table[top + x];
+    }
+
+    // Same handling of flat windows as OpenCV's TM_CCOEFF_NORMED
+    static double normalise(double numerator, double denominator) {
+        if (std::fabs(numerator) < denominator) {
+            return numerator / denominator;
+        }
+        if (std::fabs(numerator) < denominator * 1.125) {
+            return numerator > 0 ? 1.0 : -1.0;
+        }
+        return 0.0;
+    }
+
+    int width_ = 0;
+    int height_ = 0;
+    double norm_ = 0.0;
+    std::vector<float> zero_mean_;
+    std::vector<float> pixels_;
+    std::vector<double> sums_;
+    std::vector<double> squares_;
+    std::mutex mutex_;
+};
+
+}  // namespace
+
+PYBIND11_MODULE(fastmatch, m) {
+    m.doc() = "Native TM_CCOEFF_NORMED template matching for small regions";
+    py::class_<Matcher>(m, "Matcher")
+        .def(py::init<py::array_t<std::uint8_t, py::array::c_style | py::array::forcecast>>(), py::arg("template"))
+        .def_property_readonly("width", &Matcher::width)
+        .def_property_readonly("height", &Matcher::height)
+        .def("match", &Matcher::match, py::arg("image"), "Correlation map over a grayscale image (a new array)");
+}
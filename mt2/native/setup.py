@@ -0,0 +1,26 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Build script for the optional native matcher.
+
+    pip install pybind11
+    cd mt2/native && python setup.py build_ext --inplace
+
+Without the built module the matchers keep using OpenCV.
+"""
+
+from pybind11.setup_helpers import Pybind11Extension, build_ext
+from setuptools import setup
+
+setup(
+    name="fastmatch",
+    ext_modules=[
+        Pybind11Extension(
+            "fastmatch",
+            ["fastmatch.cpp"],
+            cxx_std=17,
+            extra_compile_args=["-O3", "-fopenmp-simd"],
+        )
+    ],
+    cmdclass={"build_ext": build_ext},
+)
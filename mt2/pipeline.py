@@ -0,0 +1,176 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Pipelined capture -> detect -> act runtime.
+A capture thread owns the capture backend and hands frames to the detection
+loop through a latest-value slot; actions go out through the InputDispatcher
+worker. While polling fast, the next tick's frame is captured while the caller
+sleeps, timed to finish just as that tick is due.
+"""
+
+import threading
+import time
+from collections import deque
+
+from frame import Frame
+
+
+class LatestValue:
+    """Bounded (size one) queue that always holds the newest value"""
+
+    def __init__(self):
+        self._condition = threading.Condition()
+        self._value = None
+        self._version = 0
+
+    def put(self, value):
+        with self._condition:
+            self._value = value
+            self._version += 1
+            self._condition.notify_all()
+
+    def peek(self):
+        """Return (version, value) without waiting"""
+        with self._condition:
+            return self._version, self._value
+
+    def wait_newer(self, version, timeout=None):
+        """Wait for a value newer than `version`; returns (version, value) or (version, None)"""
+        deadline = None if timeout is None else time.monotonic() + timeout
+        with self._condition:
+            while self._version <= version:
+                remaining = None if deadline is None else deadline - time.monotonic()
+                if remaining is not None and remaining <= 0:
+                    return version, None
+                self._condition.wait(remaining)
+            return self._version, self._value
+
+
+class PipelinedRuntime:
+    """Runs capture on its own thread while GameAutomation detects on the caller's thread"""
+
+    def __init__(self, automation, max_frame_age=0.1, prefetch_interval=0.25, timeout=2.0):
+        self.automation = automation
+        self.max_frame_age = max_frame_age  # Older prefetched frames are recaptured
+        self.prefetch_interval = prefetch_interval  # Prefetch when polling at least this fast
+        self.timeout = timeout
+        self.prefetch = False
+        self.capture_time = 0.0  # Smoothed seconds per tick capture, how early a prefetch starts
+
+        self._latest = LatestValue()
+        self._consumed_version = 0
+        self._requests = deque()  # (region, LatestValue reply) for explicit captures
+        self._tick_wanted = False
+        self._prefetch_at = None  # Monotonic time the scheduled prefetch starts
+        self._capturing_tick = False  # A tick frame is being grabbed and will be put shortly
+        self._condition = threading.Condition()
+        self._running = False
+        self._thread = None
+
+    @property
+    def capture_thread(self):
+        return self._thread
+
+    def start(self):
+        self._running = True
+        self._thread = threading.Thread(target=self._capture_loop, name="capture", daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        with self._condition:
+            self._running = False
+            self._condition.notify_all()
+        if self._thread is not None:
+            self._thread.join(timeout=self.timeout)
+            self._thread = None
+
+    def set_poll_interval(self, delay):
+        """Tell the pipeline the next tick is `delay` seconds away.
+
+        When polling fast, the tick frame is captured one capture time before
+        then, so it arrives fresh instead of aging through the whole sleep.
+        """
+        self.prefetch = delay <= self.prefetch_interval
+        with self._condition:
+            if self.prefetch:
+                self._prefetch_at = time.monotonic() + max(0.0, delay - self.capture_time)
+            else:
+                self._prefetch_at = None
+            self._condition.notify()
+
+    def request_frame(self, region=None):
+        """Capture a specific region on the capture thread and wait for it"""
+        reply = LatestValue()
+        with self._condition:
+            self._requests.append((region, reply))
+            self._condition.notify()
+        _, frame = reply.wait_newer(0, self.timeout)
+        if frame is None:
+            raise RuntimeError("Capture thread did not deliver a frame in time")
+        return frame
+
+    def next_frame(self):
+        """Newest tick frame; reuses a fresh prefetched frame, captures otherwise"""
+        version, frame = self._latest.peek()
+        fresh = (
+            frame is not None
+            and version > self._consumed_version
+            and time.monotonic() - frame.timestamp <= self.max_frame_age
+            and frame.origin == self._tick_origin()
+        )
+        if not fresh:
+            with self._condition:
+                self._prefetch_at = None  # Due now: capture instead of waiting for the schedule
+                if not self._capturing_tick:
+                    self._tick_wanted = True
+                    self._condition.notify()
+            version, frame = self._latest.wait_newer(version, self.timeout)
+            if frame is None:
+                raise RuntimeError("Capture thread did not deliver a frame in time")
+
+        self._consumed_version = version
+        return frame
+
+    def _tick_origin(self):
+        region = self.automation.tick_region()
+        return (int(region[0]), int(region[1])) if region is not None else (0, 0)
+
+    def _capture_loop(self):
+        backend = self.automation.capture
+        metrics = self.automation.metrics
+        while True:
+            with self._condition:
+                while self._running and not self._requests and not self._tick_wanted:
+                    if self._prefetch_at is None:
+                        self._condition.wait()
+                        continue
+                    remaining = self._prefetch_at - time.monotonic()
+                    if remaining <= 0:
+                        self._prefetch_at = None
+                        self._tick_wanted = True
+                    else:
+                        self._condition.wait(remaining)
+                if not self._running:
+                    break
+                request = self._requests.popleft() if self._requests else None
+                if request is None:
+                    self._tick_wanted = False
+                    self._capturing_tick = True
+
+            try:
+                if request is not None:
+                    region, reply = request
+                    reply.put(Frame.capture(backend, region, metrics).detach())
+                else:
+                    # The backend reuses its buffer, so detach before handing over
+                    frame = Frame.capture(backend, self.automation.tick_region(), metrics).detach()
+                    elapsed = time.monotonic() - frame.timestamp
+                    self.capture_time = elapsed if not self.capture_time else 0.8 * self.capture_time + 0.2 * elapsed
+                    self._latest.put(frame)
+            except Exception as e:
+                self.automation.log.error("Capture thread failed to grab a frame: {}", e, every=1.0)
+                time.sleep(0.1)
+            finally:
+                if request is None:
+                    with self._condition:
+                        self._capturing_tick = False
@@ -0,0 +1,139 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Always-on frame recorder.
+The last few seconds of health ROI crops and detector outputs are kept in a
+preallocated in-memory ring buffer. On death or on a hotkey they are dumped to
+a directory of chunked .npy files that np.load(..., mmap_mode="r") can map
+directly, which the replay benchmark reads as well.
+"""
+
+import json
+import os
+import threading
+import time
+
+import numpy as np
+
+from log import get_logger
+
+# Detector outputs stored next to every crop
+META_DTYPE = np.dtype([
+    ("timestamp", np.float64),  # time.monotonic() of the capture
+    ("health", np.float32),  # Health ratio, NaN when not read this tick
+    ("empty", np.bool_),  # Empty health bar detected
+    ("state", "U12"),  # Health read outcome of the tick: "empty", "potion" (burst sent) or "ok"
+    ("origin_x", np.int32),  # Screen position of the crop
+    ("origin_y", np.int32),
+])
+
+
+class FrameRecorder:
+    """Ring buffer of recent ROI crops, dumped to disk on demand"""
+
+    def __init__(self, seconds=10.0, max_rate=20.0, output_dir="recordings", chunk_frames=64, log=None):
+        self.log = log or get_logger()
+        self.capacity = max(1, int(seconds * max_rate))
+        self.min_interval = 1.0 / max_rate if max_rate > 0 else 0.0
+        self.output_dir = output_dir
+        self.chunk_frames = chunk_frames
+
+        self._crops = None  # Allocated on the first frame, once the ROI size is known
+        self._meta = np.zeros(self.capacity, dtype=META_DTYPE)
+        self._index = 0
+        self._filled = 0
+        self._last_record = -1.0
+        self._lock = threading.Lock()
+
+    @property
+    def enabled(self):
+        return self.capacity > 0
+
+    def __len__(self):
+        return self._filled
+
+    def record(self, crop_bgr, timestamp, health=None, empty=False, state="", origin=(0, 0)):
+        """Store one crop and its detector outputs (no allocation after the first call)"""
+        if timestamp - self._last_record < self.min_interval:
+            return False
+
+        with self._lock:
+            if self._crops is None or self._crops.shape[1:] != crop_bgr.shape:
+                # ROI size changed (first frame or re-acquisition): start a new buffer
+                self._crops = np.empty((self.capacity,) + crop_bgr.shape, dtype=np.uint8)
+                self._index = 0
+                self._filled = 0
+
+            slot = self._index
+            np.copyto(self._crops[slot], crop_bgr)
+            self._meta[slot] = (
+                timestamp,
+                np.nan if health is None else health,
+                bool(empty),
+                state,
+                origin[0],
+                origin[1],
+            )
+            self._index = (slot + 1) % self.capacity
+            self._filled = min(self._filled + 1, self.capacity)
+            self._last_record = timestamp
+        return True
+
+    def snapshot(self):
+        """Oldest-to-newest copies of the buffered crops and metadata"""
+        with self._lock:
+            if not self._filled:
+                return None, None
+            if self._filled < self.capacity:
+                order = np.arange(self._filled)
+            else:
+                order = (np.arange(self.capacity) + self._index) % self.capacity
+            return self._crops[order], self._meta[order]
+
+    def dump(self, reason="manual", background=True):
+        """Write the buffer to <output_dir>/<time>_<reason>/; returns the directory or None"""
+        crops, meta = self.snapshot()
+        if crops is None:
+            self.log.warning("Recorder is empty, nothing to dump")
+            return None
+
+        path = os.path.join(self.output_dir, f"{time.strftime('%Y%m%d_%H%M%S')}_{reason}")
+        if background:
+            threading.Thread(target=self._write, args=(path, crops, meta), name="recorder-dump", daemon=True).start()
+        else:
+            self._write(path, crops, meta)
+        return path
+
+    def _write(self, path, crops, meta):
+        try:
+            os.makedirs(path, exist_ok=True)
+            chunks = []
+            for number, start in enumerate(range(0, len(crops), self.chunk_frames)):
+                name = f"crops_{number:03d}.npy"
+                np.save(os.path.join(path, name), np.ascontiguousarray(crops[start:start + self.chunk_frames]))
+                chunks.append(name)
+            np.save(os.path.join(path, "meta.npy"), meta)
+            with open(os.path.join(path, "index.json"), "w") as f:
+                json.dump({
+                    "frames": int(len(crops)),
+                    "shape": list(crops.shape[1:]),
+                    "chunk_frames": self.chunk_frames,
+                    "chunks": chunks,
+                    "meta": "meta.npy",
+                }, f, indent=2)
+            self.log.info("💾 Recorder: saved {} frame(s) to {}", len(crops), path)
+        except OSError as e:
+            self.log.error("Recorder dump to {} failed: {}", path, e)
+
+
+def load_recording(path, mmap=True):
+    """Yield (frame index, BGR crop, metadata row) from a recorder dump directory"""
+    with open(os.path.join(path, "index.json")) as f:
+        index = json.load(f)
+    meta = np.load(os.path.join(path, index["meta"]))
+    frame = 0
+    for name in index["chunks"]:
+        chunk = np.load(os.path.join(path, name), mmap_mode="r" if mmap else None)
+        for crop in chunk:
+            yield frame, crop, meta[frame]
+            frame += 1
@@ -0,0 +1,72 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Region-of-interest locking.
+After one full-screen search finds where a UI element lives, only a padded
+region around it has to be captured and matched on later ticks.
+"""
+
+
+class RoiLock:
+    """Remember the screen position of a matched element and re-acquire it when lost"""
+
+    def __init__(self, padding=20, lock_threshold=0.6, keep_threshold=0.45, max_misses=3):
+        self.padding = padding  # Extra pixels around the element on every side
+        self.lock_threshold = lock_threshold  # Score needed to lock from a full search
+        self.keep_threshold = keep_threshold  # Score needed to stay locked
+        self.max_misses = max_misses  # Consecutive weak scores before releasing
+        self.region = None  # (x, y, width, height) of the element in screen coordinates
+        self.misses = 0
+
+    @property
+    def locked(self):
+        return self.region is not None
+
+    def lock(self, location, size, score):
+        """Lock onto an element found at `location` (screen coords) with `size` (w, h)"""
+        if score < self.lock_threshold:
+            return False
+        self.region = (int(location[0]), int(location[1]), int(size[0]), int(size[1]))
+        self.misses = 0
+        return True
+
+    def update(self, location, size, score):
+        """Feed a match made inside the ROI; returns False once the lock is released"""
+        if score >= self.keep_threshold:
+            # Follow small moves of the element so the ROI stays centred on it
+            self.region = (int(location[0]), int(location[1]), int(size[0]), int(size[1]))
+            self.misses = 0
+            return True
+
+        self.misses += 1
+        if self.misses >= self.max_misses:
+            self.release()
+            return False
+        return True
+
+    def release(self):
+        self.region = None
+        self.misses = 0
+
+    def search_region(self, screen_size=None):
+        """Padded (x, y, width, height) region to capture/match, clipped to the screen"""
+        if self.region is None:
+            return None
+        x, y, w, h = self.region
+        x0 = max(0, x - self.padding)
+        y0 = max(0, y - self.padding)
+        x1 = x + w + self.padding
+        y1 = y + h + self.padding
+        if screen_size is not None:
+            x1 = min(x1, screen_size[0])
+            y1 = min(y1, screen_size[1])
+        return x0, y0, x1 - x0, y1 - y0
+
+
+def union_region(a, b):
+    """Smallest (x, y, width, height) region covering regions `a` and `b`"""
+    x0 = min(a[0], b[0])
+    y0 = min(a[1], b[1])
+    x1 = max(a[0] + a[2], b[0] + b[2])
+    y1 = max(a[1] + a[3], b[1] + b[3])
+    return x0, y0, x1 - x0, y1 - y0
@@ -0,0 +1,106 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Adaptive polling scheduler.
+Instead of fixed sleeps, the delay before the next check is chosen from the
+current state and the recent health trend: fast while health is falling,
+slowly backing off while it is stable, and slow while dead.
+"""
+
+import time
+from collections import deque
+
+
+class AdaptivePollingScheduler:
+    """Choose the delay before the next tick within latency and CPU budgets"""
+
+    ALIVE = "alive"
+    COMBAT = "combat"
+    DEAD = "dead"
+    RESPAWNING = "respawning"
+
+    def __init__(
+        self,
+        latency_budget=0.2,
+        cpu_budget=0.25,
+        min_interval=0.02,
+        idle_interval=1.0,
+        dead_interval=0.5,
+        backoff=1.5,
+        falling_rate=0.02,
+        low_health=0.6,
+        trend_window=1.5,
+    ):
+        self.latency_budget = latency_budget  # Max seconds from a health change to our reaction
+        self.cpu_budget = cpu_budget  # Max fraction of wall time spent working
+        self.min_interval = min_interval
+        self.idle_interval = idle_interval  # Cap while health is stable
+        self.dead_interval = dead_interval
+        self.backoff = backoff  # Interval growth per stable tick
+        self.falling_rate = falling_rate  # Health ratio lost per second that counts as combat
+        self.low_health = low_health  # Below this we always poll fast
+        self.trend_window = trend_window  # Seconds of readings used for the trend
+
+        self._readings = deque()  # (timestamp, health ratio)
+        self._interval = min_interval
+
+    def record_health(self, ratio, timestamp=None):
+        """Feed a health reading (0.0-1.0)"""
+        now = time.monotonic() if timestamp is None else timestamp
+        self._readings.append((now, ratio))
+        while self._readings and now - self._readings[0][0] > self.trend_window:
+            self._readings.popleft()
+
+    def clear(self):
+        self._readings.clear()
+        self._interval = self.min_interval
+
+    def trend(self):
+        """Health ratio change per second over the window (negative while losing health)"""
+        if len(self._readings) < 2:
+            return 0.0
+        (t0, h0), (t1, h1) = self._readings[0], self._readings[-1]
+        if t1 - t0 <= 0:
+            return 0.0
+        return (h1 - h0) / (t1 - t0)
+
+    def classify(self):
+        """ALIVE when stable, COMBAT when health is low or falling"""
+        if not self._readings:
+            return self.ALIVE
+        health = self._readings[-1][1]
+        if health < self.low_health or self.trend() <= -self.falling_rate:
+            return self.COMBAT
+        return self.ALIVE
+
+    def next_delay(self, state, work_time=0.0, due=None, wake=None):
+        """Seconds to sleep before the next tick, given how long this tick worked.
+
+        `due` is the time until a dead state's next timed event; dead_interval is used without it.
+        `wake` is the time until a tick is needed anyway (a skill or predicted heal coming due):
+        it can shorten the delay, but never below min_interval or the CPU budget floor.
+        """
+        # Never work more than cpu_budget of the time: work / (work + delay) <= budget
+        cpu_floor = work_time * (1.0 / self.cpu_budget - 1.0) if self.cpu_budget > 0 else 0.0
+
+        delay = self._state_delay(state, work_time, due)
+        if wake is not None:
+            delay = min(delay, max(self.min_interval, wake))
+        return max(delay, cpu_floor)
+
+    def _state_delay(self, state, work_time, due):
+        if state in (self.DEAD, self.RESPAWNING):
+            self._interval = self.min_interval
+            return self.dead_interval if due is None else max(self.min_interval, due)
+
+        if state == self.ALIVE:
+            state = self.classify()
+
+        if state == self.COMBAT:
+            # Keep capture + decision latency within the budget
+            self._interval = self.min_interval
+            return max(self.min_interval, self.latency_budget - work_time)
+
+        # Stable: back off gradually towards the idle interval
+        self._interval = min(self.idle_interval, max(self.min_interval, self._interval * self.backoff))
+        return self._interval
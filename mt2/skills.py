@@ -0,0 +1,137 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Skill rotation.
+Skills cooling down wait in a timer wheel keyed on time.monotonic(); ready
+skills are queued on the InputDispatcher one at a time, highest priority
+first and no faster than the global cooldown. Heals use a higher dispatcher
+priority, so a potion always goes out before the next skill.
+"""
+
+import heapq
+import itertools
+
+from input_dispatcher import InputDispatcher
+
+
+class TimerWheel:
+    """Hashed timer wheel: O(1) scheduling, expiry checks only touch the slots passed since last time"""
+
+    def __init__(self, resolution=0.05, slots=128):
+        self.resolution = resolution  # Seconds per slot
+        self._slots = [[] for _ in range(slots)]
+        self._cursor = None  # Last slot tick processed
+        self._count = 0
+
+    def __len__(self):
+        return self._count
+
+    def _tick(self, when):
+        return int(when / self.resolution)
+
+    def schedule(self, when, item):
+        """Fire `item` once time.monotonic() reaches `when`"""
+        self._slots[self._tick(when) % len(self._slots)].append((when, item))
+        self._count += 1
+
+    def advance(self, now):
+        """Items whose time has come, in due order"""
+        target = self._tick(now)
+        if self._cursor is None:
+            self._cursor = target
+        ticks = range(self._cursor, target + 1)
+        if len(ticks) > len(self._slots):
+            ticks = range(target - len(self._slots) + 1, target + 1)  # Every slot once
+
+        due = []
+        for tick in ticks:
+            slot = self._slots[tick % len(self._slots)]
+            if not slot:
+                continue
+            # Entries a full turn or more ahead stay in the slot
+            keep = [entry for entry in slot if entry[0] > now]
+            if len(keep) != len(slot):
+                due.extend(entry for entry in slot if entry[0] <= now)
+                slot[:] = keep
+        self._cursor = target
+        self._count -= len(due)
+        due.sort(key=lambda entry: entry[0])
+        return [item for _, item in due]
+
+    def next_expiry(self):
+        """Earliest scheduled time, None when empty"""
+        if not self._count:
+            return None
+        return min(when for slot in self._slots for when, _ in slot)
+
+    def clear(self):
+        for slot in self._slots:
+            slot.clear()
+        self._count = 0
+        self._cursor = None
+
+
+class Skill:
+    """A skill key with its cooldown and rotation priority (lower goes first)"""
+
+    def __init__(self, key, cooldown=5.0, priority=0, duration=0.1):
+        self.key = key
+        self.cooldown = cooldown
+        self.priority = priority
+        self.duration = duration  # Seconds the key is held
+        self.ready_time = 0.0
+        self.uses = 0
+
+
+class SkillRotation:
+    """Queue skills on the input dispatcher as their cooldowns and the global cooldown allow"""
+
+    def __init__(self, skills, dispatcher, global_cooldown=1.0, resolution=0.05, tag="skill"):
+        self.skills = list(skills)
+        self.dispatcher = dispatcher
+        self.global_cooldown = global_cooldown
+        self.tag = tag
+        self._wheel = TimerWheel(resolution=resolution)
+        self._ready = []  # heap of (priority, seq, skill)
+        self._seq = itertools.count()
+        self._global_ready = 0.0
+        self.reset()
+
+    def reset(self, now=0.0):
+        """Every skill ready from `now` on, e.g. after a respawn"""
+        self._wheel.clear()
+        self._ready = []
+        self._global_ready = now
+        for skill in self.skills:
+            skill.ready_time = now
+            heapq.heappush(self._ready, (skill.priority, next(self._seq), skill))
+
+    def cancel(self):
+        """Drop skill presses still waiting in the dispatcher"""
+        self.dispatcher.cancel(self.tag)
+
+    def update(self, now):
+        """Queue the best ready skill if the global cooldown allows; returns it or None"""
+        for skill in self._wheel.advance(now):
+            heapq.heappush(self._ready, (skill.priority, next(self._seq), skill))
+
+        # One skill in flight at a time keeps the dispatcher queue short, so heals cut in quickly
+        if not self._ready or now < self._global_ready or self.dispatcher.pending(self.tag):
+            return None
+
+        _, _, skill = heapq.heappop(self._ready)
+        self.dispatcher.press(skill.key, skill.duration, priority=InputDispatcher.PRIORITY_SKILL, tag=self.tag)
+        skill.uses += 1
+        skill.ready_time = now + skill.cooldown
+        self._global_ready = now + self.global_cooldown
+        self._wheel.schedule(skill.ready_time, skill)
+        return skill
+
+    def next_due(self, now):
+        """Seconds until update() could queue another skill (for the loop's sleep)"""
+        if self._ready:
+            return max(0.0, self._global_ready - now)
+        expiry = self._wheel.next_expiry()
+        if expiry is None:
+            return None
+        return max(0.0, max(expiry, self._global_ready) - now)
@@ -0,0 +1,286 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Multi-instance mode: one process supervising several game clients.
+Every client window is a GameAutomation instance working in its own window
+coordinates. One capture per cycle covers all windows and each instance only
+crops its part; the template store and match pool are shared, and instance
+ticks run on a small worker pool whenever their own scheduler says they are due.
+
+Window geometries come from [[instances]] in the config file. An instance
+given a `window` (ID or title) instead captures that window by itself.
+Keys must reach the right client: with several instances, only those given a
+`window` send keys (to that window); the others refuse key presses, since a
+focused-window keyboard would heal whichever client was clicked last.
+With a control port, instances can be watched, paused, resumed and switched
+to another profile remotely; commands are applied between cycles.
+Usage: python supervisor.py --config config.toml --workers 4 --control-port 8765
+"""
+
+import argparse
+import math
+import queue
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+from capture import SharedCapture, create_capture_backend, create_window_capture
+from config import load_config
+from control import ControlServer
+from main import GameAutomation, start_hotkey_listener
+from matching import MatchPool
+from templates import TemplateStore
+
+
+class Supervisor:
+    """Schedules the ticks of several GameAutomation instances over one shared capture"""
+
+    def __init__(self, config=None, workers=4, match_workers=None, debug_mode=False, capture_backend=None):
+        self.config = load_config(config) if not hasattr(config, "resolve") else config
+        if not self.config["instances"]:
+            raise ValueError("No [[instances]] configured")
+        self.debug_mode = debug_mode
+        self.running = False
+        self._commands = queue.SimpleQueue()  # Control commands, applied by run() between cycles
+        self._wake = threading.Event()
+
+        if capture_backend is None:
+            capture_backend = create_capture_backend(debug_mode=debug_mode)
+        self.shared = SharedCapture(capture_backend)
+
+        # Decoded once for every client
+        self.template_store = TemplateStore(
+            self.config.resolve(self.config["templates"]["path"]),
+            debug_mode=debug_mode,
+            bundle_path=self.config.resolve(self.config["templates"]["bundle"]) or None,
+            ui_scales=self.config["templates"]["ui_scales"],
+        )
+        self.match_pool = MatchPool(match_workers)
+
+        self.instances = []
+        self._keys = []  # (per-window key sender or None, reason keys are blocked or None) of every instance
+        several = len(self.config["instances"]) > 1
+        for index, settings in enumerate(self.config["instances"]):
+            name = settings.get("name", f"client{index + 1}")
+            window = settings.get("window")
+            if window:
+                capture = create_window_capture(window, debug_mode=debug_mode)
+                origin = (0, 0)  # Clicks use the window's current position
+            else:
+                capture = self.shared.view(settings["geometry"])
+                origin = settings["geometry"][:2]
+            self._keys.append(self._key_route(name, capture, several))
+            profile = settings.get("profile")  # Own detectors/thresholds/keys, templates stay shared
+            self.instances.append(self._create_instance(
+                index, name, capture, origin, self.config.resolve(profile) if profile else self.config,
+            ))
+        self._due = [0.0] * len(self.instances)
+        self._executor = ThreadPoolExecutor(max_workers=max(1, workers), thread_name_prefix="instance")
+
+    @staticmethod
+    def _key_route(name, capture, several):
+        """(key sender, blocked reason) for an instance: its own window's keys, or none when shared"""
+        if not several:
+            return None, None  # A single client is the focused window
+        if not hasattr(capture, "key_sender"):
+            print(f"WARNING: Instance '{name}' has no `window`, its keys are disabled "
+                  f"(they would go to whichever client has focus)")
+            return None, "no per-window key input (set `window` for this instance)"
+        try:
+            return capture.key_sender(), None
+        except (RuntimeError, OSError) as e:
+            print(f"WARNING: Instance '{name}' cannot send keys to its window, its keys are disabled: {e}")
+            return None, f"no per-window key input ({e})"
+
+    def _create_instance(self, index, name, capture, origin, config):
+        keys, keys_blocked = self._keys[index]
+        return GameAutomation(
+            debug_mode=self.debug_mode,
+            pipelined=False,
+            metrics_interval=0,
+            record_seconds=self.config["instances"][index].get("record_seconds", 0),
+            keys=keys,
+            keys_blocked=keys_blocked,
+            capture_backend=capture,
+            config=config,
+            template_store=self.template_store,
+            match_pool=self.match_pool,
+            screen_origin=origin,
+            name=name,
+        )
+
+    def _indices(self, instance=None):
+        """Indices of the instance named `instance`, or of all of them"""
+        if instance is None:
+            return list(range(len(self.instances)))
+        for index, automation in enumerate(self.instances):
+            if automation.name == instance:
+                return [index]
+        raise ValueError(f"Unknown instance '{instance}'")
+
+    def _queue(self, command, *args):
+        self._commands.put((command, args))
+        self._wake.set()
+
+    # Control endpoint commands: validated here, applied by run() on the loop thread
+
+    def status(self):
+        return [instance.status() for instance in self.instances]
+
+    def start(self, instance=None):
+        indices = self._indices(instance)
+        self._queue(self._resume, indices)
+        return {"instances": [self.instances[i].name for i in indices], "running": True}
+
+    def pause(self, instance=None):
+        indices = self._indices(instance)
+        self._queue(self._pause, indices)
+        return {"instances": [self.instances[i].name for i in indices], "running": False}
+
+    def switch_profile(self, profile, instance=None):
+        indices = self._indices(instance)
+        config = load_config(self.config.resolve(profile))
+        self._queue(self._switch_profile, indices, config)
+        return {"instances": [self.instances[i].name for i in indices], "profile": config.path}
+
+    def _pause(self, indices):
+        for index in indices:
+            instance = self.instances[index]
+            if instance.automation_running:
+                instance.automation_running = False
+                instance.end_session()
+            self._due[index] = math.inf
+
+    def _resume(self, indices):
+        for index in indices:
+            instance = self.instances[index]
+            if not instance.automation_running:
+                self.shared.refresh(time.monotonic())
+                instance.start_session()
+                instance.automation_running = True
+            self._due[index] = 0.0
+
+    def _switch_profile(self, indices, config):
+        for index in indices:
+            old = self.instances[index]
+            was_running = old.automation_running
+            self._pause([index])
+            # Same window and capture, new detectors/thresholds/keys
+            self.instances[index] = self._create_instance(index, old.name, old.capture, old.screen_origin, config)
+            if was_running:
+                self._resume([index])
+            self.instances[index].log.info("Switched to profile {}", config.path)
+
+    def _apply_commands(self):
+        while True:
+            try:
+                command, args = self._commands.get_nowait()
+            except queue.Empty:
+                return
+            try:
+                command(*args)
+            except Exception as e:
+                print(f"ERROR: Control command {command.__name__} failed: {e}")
+
+    def _step(self, index):
+        instance = self.instances[index]
+        try:
+            return instance.step()
+        except Exception as e:
+            instance.log.error("Tick failed: {}", e, every=1.0)
+            return None, 1.0
+
+    def run(self, summary_interval=30.0, control_port=None):
+        """Tick every instance when it is due until stop() or 'q'"""
+        self.running = True
+        control_config = self.config["control"]
+        control_port = control_config["port"] if control_port is None else control_port
+        control = None
+        if control_port:
+            control = ControlServer(
+                self.status,
+                {"start": self.start, "stop": self.pause, "profile": self.switch_profile},
+                host=control_config["host"],
+                port=control_port,
+            )
+
+        def on_key_press(key):
+            if getattr(key, "char", None) == "q":
+                print("Stopping all instances...")
+                self.stop()
+                return False
+
+        listener = start_hotkey_listener(on_key_press)
+        next_summary = time.monotonic() + summary_interval
+        try:
+            self.shared.refresh(time.monotonic())
+            list(self._executor.map(lambda instance: instance.start_session(), self.instances))
+            for instance in self.instances:
+                instance.automation_running = True
+            if control is not None:
+                control.start()
+            print(f"Supervising {len(self.instances)} instance(s): "
+                  f"{', '.join(instance.name for instance in self.instances)}")
+
+            while self.running:
+                self._apply_commands()
+                now = time.monotonic()
+                due = [index for index, when in enumerate(self._due) if when <= now]
+                if not due:
+                    # Commands wake the loop early; paused instances are never due
+                    self._wake.wait(min(max(0.0, min(self._due) - now), 1.0))
+                    self._wake.clear()
+                    continue
+
+                # One grab for every instance ticking this cycle
+                self.shared.refresh(now)
+                for index, (_, delay) in zip(due, self._executor.map(self._step, due)):
+                    self._due[index] = time.monotonic() + delay
+
+                if summary_interval > 0 and now >= next_summary:
+                    next_summary = now + summary_interval
+                    for instance in self.instances:
+                        instance.log.info("{}", instance.metrics.format_summary())
+        except KeyboardInterrupt:
+            print("Supervisor stopped by user")
+        finally:
+            self.running = False
+            listener.stop()
+            if control is not None:
+                control.stop()
+            for instance in self.instances:
+                if instance.automation_running:
+                    instance.automation_running = False
+                    instance.end_session()
+            self._executor.shutdown(wait=False)
+            self.match_pool.close()
+            for keys, _ in self._keys:
+                if keys is not None and hasattr(keys, "close"):
+                    keys.close()
+
+    def stop(self):
+        self.running = False
+        self._wake.set()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Supervise several game clients from one process")
+    parser.add_argument("--config", metavar="PATH", help="TOML file with [[instances]] (default: config.toml)")
+    parser.add_argument("--workers", type=int, default=4, help="Threads running instance ticks (default: 4)")
+    parser.add_argument("--match-workers", type=int, default=None,
+                        help="Threads for full-screen template searches (default: one per core, up to 8)")
+    parser.add_argument("--metrics-interval", type=float, default=30.0,
+                        help="Seconds between per-instance timing summaries, 0 to disable (default: 30)")
+    parser.add_argument("--control-port", type=int, default=None,
+                        help="Serve telemetry and start/stop/profile commands on localhost:PORT, 0 disables (also control.port)")
+    parser.add_argument("--debug", action="store_true", help="Enable verbose debug diagnostics")
+    args = parser.parse_args()
+
+    supervisor = Supervisor(args.config, workers=args.workers, match_workers=args.match_workers,
+                            debug_mode=args.debug)
+    print("Press 'q' to stop all instances")
+    supervisor.run(summary_interval=args.metrics_interval, control_port=args.control_port)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,282 @@
+"""
+LICENSE: BSD 3-Clause License
+Author:Cyber-syntax
+Template store.
+Templates never change at runtime, so every representation the matchers need
+(grayscale, contiguous, scaled, normalisation statistics) is built once at
+load time and nothing is converted again in the hot loop.
+Templates captured at one UI scale also get resized variants, so other
+resolutions only need the winning scale picked once during calibration; a
+variant is built the first time its scale is asked for, so a start that knows
+its scale from the calibration cache never builds the others.
+Decoded images can be kept in a bundle (one raw .npy array plus a JSON index)
+that later starts memory-map instead of decoding every PNG again.
+"""
+
+import json
+import os
+import threading
+
+import cv2
+import numpy as np
+
+
+class Template:
+    """A template image kept in ready-to-match form"""
+
+    def __init__(self, name, bgr, scales=()):
+        self.name = name
+        self.bgr = np.ascontiguousarray(bgr)
+        self.gray = np.ascontiguousarray(cv2.cvtColor(self.bgr, cv2.COLOR_BGR2GRAY))
+        self.height, self.width = self.gray.shape
+
+        # Zero-mean float copy and its L2 norm: the template half of a normalised
+        # cross-correlation, for matchers that do not go through cv2.matchTemplate
+        gray_f = self.gray.astype(np.float32)
+        self.mean = float(gray_f.mean())
+        self.zero_mean = np.ascontiguousarray(gray_f - self.mean)
+        self.norm = float(np.sqrt(np.square(self.zero_mean).sum()))
+
+        self._scaled = {1.0: self.gray}
+        for scale in scales:
+            self.scaled(scale)
+
+    @property
+    def size(self):
+        """(width, height) in pixels"""
+        return self.width, self.height
+
+    @property
+    def shape(self):
+        return self.bgr.shape
+
+    def resized(self, scale, scales=()):
+        """New Template for the same element shown at UI scale `scale`"""
+        interpolation = cv2.INTER_AREA if scale < 1.0 else cv2.INTER_LINEAR
+        width = max(1, int(round(self.width * scale)))
+        height = max(1, int(round(self.height * scale)))
+        bgr = cv2.resize(self.bgr, (width, height), interpolation=interpolation)
+        return Template(self.name, bgr, scales=scales)
+
+    def scaled(self, scale):
+        """Grayscale template resized by `scale`, cached after the first call"""
+        key = round(float(scale), 4)
+        cached = self._scaled.get(key)
+        if cached is not None:
+            return cached
+
+        width = max(1, int(round(self.width * key)))
+        height = max(1, int(round(self.height * key)))
+        interpolation = cv2.INTER_AREA if key < 1.0 else cv2.INTER_LINEAR
+        cached = np.ascontiguousarray(
+            cv2.resize(self.gray, (width, height), interpolation=interpolation)
+        )
+        self._scaled[key] = cached
+        return cached
+
+
+class TemplateBundle:
+    """Cache of decoded template images in one memory-mappable array.
+
+    `<path>.npy` holds every BGR image back to back as flat uint8 data and
+    `<path>.json` maps names to offsets, shapes and the source file's size and
+    mtime, so an entry is only trusted while its PNG is unchanged.
+    """
+
+    def __init__(self, path):
+        self.path = path
+        self._index = {}
+        self._data = None
+        try:
+            with open(path + ".json") as f:
+                self._index = json.load(f)
+            self._data = np.load(path + ".npy", mmap_mode="r")
+        except (OSError, ValueError):
+            self._index = {}
+            self._data = None
+
+    @staticmethod
+    def _stamp(filepath):
+        stat = os.stat(filepath)
+        return [stat.st_size, stat.st_mtime_ns]
+
+    def get(self, name, filepath):
+        """Memory-mapped BGR image cached for `name`, None if missing or stale"""
+        entry = self._index.get(name)
+        if entry is None or self._data is None:
+            return None
+        try:
+            if entry["source"] != os.path.basename(filepath) or entry["stamp"] != self._stamp(filepath):
+                return None
+        except OSError:
+            return None
+        offset, shape = entry["offset"], tuple(entry["shape"])
+        count = int(np.prod(shape))
+        return self._data[offset:offset + count].reshape(shape)
+
+    def save(self, images):
+        """Write {name: (filepath, bgr image)} as the new bundle"""
+        index = {}
+        parts = []
+        offset = 0
+        for name, (filepath, image) in images.items():
+            flat = np.ascontiguousarray(image, dtype=np.uint8).reshape(-1)
+            index[name] = {
+                "source": os.path.basename(filepath),
+                "stamp": self._stamp(filepath),
+                "offset": offset,
+                "shape": list(image.shape),
+            }
+            parts.append(flat)
+            offset += flat.size
+
+        os.makedirs(os.path.dirname(self.path) or ".", exist_ok=True)
+        data = np.concatenate(parts) if parts else np.zeros(0, dtype=np.uint8)
+        # Write then rename so a concurrent start never maps a half-written file
+        np.save(self.path + ".tmp.npy", data)
+        with open(self.path + ".tmp.json", "w") as f:
+            json.dump(index, f, indent=2)
+        os.replace(self.path + ".tmp.npy", self.path + ".npy")
+        os.replace(self.path + ".tmp.json", self.path + ".json")
+        self._index = index
+        self._data = np.load(self.path + ".npy", mmap_mode="r")
+
+
+class TemplateStore:
+    """Loads template images once and keeps them by name.
+
+    Templates can be registered up front and are only decoded on their first
+    get(); with a `bundle_path`, decoded images come from a TemplateBundle.
+    `ui_scales` are the UI scales every template can get a variant for (built
+    on first use); get() returns the variant of the requested or the active
+    `ui_scale`. One store
+    can be shared by several GameAutomation instances (and threads).
+    """
+
+    def __init__(self, base_path, scales=(), debug_mode=False, bundle_path=None, ui_scales=(1.0,)):
+        self.base_path = base_path
+        self.scales = tuple(scales)  # Matcher downscales cached on every template
+        self.debug_mode = debug_mode
+        self.templates = {}  # Templates as captured (UI scale 1.0)
+        self.ui_scales = tuple(sorted({round(float(s), 4) for s in ui_scales} | {1.0}))
+        self.ui_scale = 1.0
+        self._variants = {}  # name -> {UI scale: Template}
+        self._lock = threading.RLock()  # Lazy loads and bundle writes from several instances
+        self.files = {}  # Registered name -> filename, loaded lazily
+        self.bundle = TemplateBundle(bundle_path) if bundle_path else None
+        self._bundle_stale = False
+
+    def __contains__(self, name):
+        return name in self.templates or name in self.files
+
+    def register(self, name, filename):
+        """Make `filename` available as template `name` without loading it yet"""
+        self.files[name] = filename
+
+    def get(self, name, ui_scale=None):
+        """Template `name` at `ui_scale` (default: the active one), loading it on first use"""
+        variants = self._variants.get(name)
+        if variants is None:
+            if name not in self.files:
+                return None
+            with self._lock:
+                if name not in self._variants:
+                    self.load(name, self.files[name])
+                    self.save_bundle()
+            variants = self._variants.get(name)
+            if variants is None:
+                return None
+        scale = self.ui_scale if ui_scale is None else round(float(ui_scale), 4)
+        template = variants.get(scale)
+        if template is None:
+            template = self._variant(name, scale)
+        return template
+
+    def _variant(self, name, scale):
+        """Resize template `name` for UI scale `scale` on its first use"""
+        if scale not in self.ui_scales:
+            raise ValueError(f"UI scale {scale} is not precomputed (have {self.ui_scales})")
+        with self._lock:
+            variants = self._variants[name]
+            if scale not in variants:
+                variants[scale] = self.templates[name].resized(scale, self.scales)
+            return variants[scale]
+
+    def set_ui_scale(self, scale):
+        """Make get() return the variants for `scale` (one of `ui_scales`)"""
+        scale = round(float(scale), 4)
+        if scale not in self.ui_scales:
+            raise ValueError(f"UI scale {scale} is not precomputed (have {self.ui_scales})")
+        self.ui_scale = scale
+
+    def scales_by_preference(self, current=None):
+        """UI scales to try during calibration: `current` (or the active one) first, then the closest to 1.0"""
+        current = self.ui_scale if current is None else current
+        return sorted(self.ui_scales, key=lambda s: (s != current, abs(s - 1.0)))
+
+    def load(self, name, filename):
+        """Load `filename` from the store directory as template `name`; None on failure"""
+        self.files[name] = filename
+        filepath = os.path.join(self.base_path, filename)
+        if not os.path.exists(filepath):
+            print(f"ERROR: Template file not found: {filepath}")
+            return None
+
+        image = self.bundle.get(name, filepath) if self.bundle is not None else None
+        if image is not None:
+            return self._add(name, image, "bundle")
+
+        image = self._decode(filepath, filename)
+        if image is None:
+            return None
+        self._bundle_stale = self.bundle is not None
+        return self._add(name, image, filename)
+
+    def _decode(self, filepath, filename):
+        image = cv2.imread(filepath)
+        if image is None:
+            print(f"ERROR: Could not load {filename} - cv2.imread returned None")
+            # Try with PIL as backup
+            try:
+                from PIL import Image
+
+                image = cv2.cvtColor(np.array(Image.open(filepath).convert("RGB")), cv2.COLOR_RGB2BGR)
+                print(f"SUCCESS: Loaded via PIL: {filename}")
+            except Exception as e:
+                print(f"ERROR: PIL also failed for {filename}: {e}")
+                return None
+        return image
+
+    def _add(self, name, image, source):
+        template = Template(name, image, scales=self.scales)
+        self.templates[name] = template
+        self._variants[name] = {1.0: template}
+        if self.debug_mode:
+            print(f"DEBUG: Template '{name}' ready from {source} "
+                  f"({template.width}x{template.height}, mean {template.mean:.1f})")
+        return self.get(name)
+
+    def load_all(self):
+        """Load every registered template now (warm start)"""
+        for name in list(self.files):
+            self.get(name)
+
+    def save_bundle(self):
+        """Rewrite the bundle if any template had to be decoded from its image file"""
+        if self.bundle is None or not self._bundle_stale:
+            return False
+        images = {}
+        for name, filename in self.files.items():
+            filepath = os.path.join(self.base_path, filename)
+            template = self.templates.get(name)
+            # Registered templates not loaded yet keep their still-valid bundle entry
+            image = template.bgr if template is not None else self.bundle.get(name, filepath)
+            if image is not None:
+                images[name] = (filepath, image)
+        try:
+            self.bundle.save(images)
+        except OSError as e:
+            print(f"WARNING: Could not write template bundle {self.bundle.path}: {e}")
+            return False
+        self._bundle_stale = False
+        return True